@@ -24,185 +24,241 @@
 
 
 
+#include <cfloat>
+
 #include "appTemplate.h"
 
-//for the channel comparison
-typedef struct ChannelScore
+/*
+Channel selection:
+The template picks the 2 of the 9 channels that best separate the person from
+the surroundings, scoring each channel by the variance ratio of the
+back-projection of its histogram inside and outside the window. A histogram
+is back-projected per bin, so the histograms of the back-projection follow
+from the bin counts of the pixels: the counts of all 9 channels over the
+window and the roi come from the frame set (see FrameSet::countBins), and
+the scores are computed from them on fixed-size arrays, with the same values
+as calcHist()/calcBackProject() on the pixels. normalize() and log() run on
+Mat headers over the arrays.
+*/
+
+typedef struct ChannelCounts
+{
+	int fore[FEATURE_CHANNEL_NUM][BIN_SLOTS];
+	int back[FEATURE_CHANNEL_NUM][BIN_SLOTS];
+}ChannelCounts;
+
+static inline void normalizeHist(float* hist, int n, double norm)
 {
-	int idx;
-	double score;
-	ChannelScore(int i,double s):idx(i), score(s){}
-}ChannelScore;
-inline bool compareChannel(ChannelScore c1,ChannelScore c2)
+	Mat h(n,1,CV_32FC1,hist);
+	normalize(h,h,norm,0.0,NORM_L1);
+}
+static inline double dotHist(const float* h1, const float* h2)
+{
+	return Mat(BIN_NUMBER,1,CV_32FC1,(void*)h1).dot(Mat(BIN_NUMBER,1,CV_32FC1,(void*)h2));
+}
+static double getVariance(const float* hist)
 {
-	return c1.score<c2.score ? true:false;
+	float idx[BIN_NUMBER];
+	for (int i=0;i<BIN_NUMBER;i++)
+		idx[i]=(float)i;
+	double mean_idx=dotHist(hist,idx);
+	float temp[BIN_NUMBER];
+	for (int i=0;i<BIN_NUMBER;i++)
+	{
+		float d=idx[i]+(float)(-mean_idx);
+		temp[i]=d*d;
+	}
+	return dotHist(hist,temp);
 }
 // Variance Ratio
-double getVR(Mat hist1,Mat hist2)
+static double getVR(const float* hist1, const float* hist2)
+{
+	float hist_mean[BIN_NUMBER];
+	for (int i=0;i<BIN_NUMBER;i++)
+		hist_mean[i]=(float)(hist1[i]*0.5+hist2[i]*0.5);
+	return getVariance(hist_mean)/(getVariance(hist1)+getVariance(hist2));
+}
+// normalized histogram (BIN_NUMBER bins over [0,255]) of the back-projection 
+// of hist on the pixels with the given bin counts
+static void getBPHist(const float* hist, const int* counts, float* bp_hist)
 {
-	Mat idx=Mat::zeros(hist1.rows,hist1.cols,CV_32FC1);
-	for (int i=0;i<idx.rows;++i)
+	const double a=BIN_NUMBER/255.0;
+	for (int k=0;k<BIN_NUMBER;k++)
+		bp_hist[k]=0;
+	for (int b=0;b<BIN_SLOTS;b++)
 	{
-		float* r_ptr=idx.ptr<float>(i);
-		r_ptr[0]=(float)i;
+		uchar v= b<BIN_NUMBER ? saturate_cast<uchar>(hist[b]) : 0;
+		int k=cvFloor(v*a);
+		if (k<BIN_NUMBER)
+			bp_hist[k]+=(float)counts[b];
 	}
-	double mean_idx=hist1.dot(idx);
-	Mat temp=idx-mean_idx;
-	temp=temp.mul(temp);
-	double variance1=hist1.dot(temp);
-
-	mean_idx=hist2.dot(idx);
-	temp=idx-mean_idx;
-	temp=temp.mul(temp);
-	double variance2=hist2.dot(temp);
-
-	Mat hist_mean=(hist1+hist2)*0.5;
-	mean_idx=hist_mean.dot(idx);
-	temp=idx-mean_idx;
-	temp=temp.mul(temp);
-	double variance_mean=hist_mean.dot(temp);
+	normalizeHist(bp_hist,BIN_NUMBER,1.0);
+}
+// variance ratio of a channel whose histogram is hist
+static double scoreChannel(const float* hist, const int* fore, const int* back)
+{
+	float hist_fore[BIN_NUMBER];
+	float hist_back[BIN_NUMBER];
+	getBPHist(hist,fore,hist_fore);
+	getBPHist(hist,back,hist_back);
+	//deal with gray image to get rid of #IND
+	double score=getVR(hist_back,hist_fore);
+	return score==score ? score:0;
+}
+// the 2 highest scored channels (on a tie the later channel)
+static void chooseChannels(const double* score, int* channels)
+{
+	channels[0]=0;
+	for (int i=1;i<FEATURE_CHANNEL_NUM;i++)
+		if (score[i]>=score[channels[0]])
+			channels[0]=i;
+	channels[1]= channels[0]==0 ? 1 : 0;
+	for (int i=channels[1]+1;i<FEATURE_CHANNEL_NUM;i++)
+		if (i!=channels[0] && score[i]>=score[channels[1]])
+			channels[1]=i;
+}
 
-	return variance_mean/(variance1+variance2);
+Rect AppTemplate::getRoiWin(Rect iniWin)
+{
+	Rect body_win=scaleWin(iniWin,1/TRACKING_TO_BODYSIZE_RATIO);
+	return Rect(body_win.x-body_win.width,body_win.y-body_win.width,3*body_win.width,2*body_win.width+body_win.height);
 }
 
-AppTemplate::AppTemplate(const Mat* frame_set, const Rect iniWin,int ID)
+AppTemplate::AppTemplate(FrameSet* frame_set, const Rect iniWin,int ID)
 	:ID(ID)//bgr,hsv,lab
 {	
 	//get roi out of frame set
 	Rect body_win=scaleWin(iniWin,1/TRACKING_TO_BODYSIZE_RATIO);
-	Rect roi_win(body_win.x-body_win.width,body_win.y-body_win.width,3*body_win.width,2*body_win.width+body_win.height);
-	body_win= body_win&Rect(0,0,frame_set[0].cols,frame_set[0].rows);
-	roi_win=roi_win&Rect(0,0,frame_set[0].cols,frame_set[0].rows);
-	Mat roi_set[]={Mat(frame_set[0],roi_win),Mat(frame_set[1],roi_win),Mat(frame_set[2],roi_win)};
+	Rect roi_win=getRoiWin(iniWin);
+	body_win= body_win&Rect(0,0,frame_set->cols(),frame_set->rows());
+	roi_win=roi_win&Rect(0,0,frame_set->cols(),frame_set->rows());
+	Mat roi_bins[FEATURE_CHANNEL_NUM];
+	frame_set->getBinRoi(roi_win,roi_bins);
 
-	
+	// foreground: the window; background: the roi out of the body
 	Rect iniWin_roi=iniWin-Point(roi_win.x,roi_win.y);
+	Rect fore_win=iniWin_roi & Rect(0,0,roi_win.width,roi_win.height);
+	Rect body_roi=body_win-Point(roi_win.x,roi_win.y);
 
-	//scores for each channel
-	list<ChannelScore> channel_score;
-	
-	Mat mask_roi(roi_set[0].rows,roi_set[0].cols,CV_8UC1,Scalar(0));
-	rectangle(mask_roi,iniWin_roi,Scalar(255),-1);
-	Mat inv_mask_roi(roi_set[0].rows,roi_set[0].cols,CV_8UC1,Scalar(255));
-	rectangle(inv_mask_roi,body_win-Point(roi_win.x,roi_win.y),Scalar(0),-1);
+	//count the bins of each channel
+	ChannelCounts counts;
+	memset(&counts,0,sizeof(counts));
+	int body[FEATURE_CHANNEL_NUM][BIN_SLOTS];
+	memset(body,0,sizeof(body));
+	frame_set->countBins(fore_win+Point(roi_win.x,roi_win.y),counts.fore);
+	frame_set->countBins(roi_win,counts.back);
+	frame_set->countBins(body_win&roi_win,body);
+	for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+		for (int b=0;b<BIN_SLOTS;b++)
+			counts.back[c][b]-=body[c][b];
 
-	//calculate score for each channel
-	Mat temp_hist;
-	Mat temp_bp;
-	int hist_size[]={BIN_NUMBER};
-	for (int i=0;i<9;i++)
+	//calculate score for each channel, with the histogram of the background
+	double channel_score[FEATURE_CHANNEL_NUM];
+	float temp_hist[BIN_NUMBER];
+	for (int i=0;i<FEATURE_CHANNEL_NUM;i++)
 	{
-		float range1[]={0,255};
-		if (i==3)
-		{
-			range1[1]=179;
-		}
-		const float* hist_range[]={range1};
-		
-		calcHist(roi_set,3,&i,inv_mask_roi,temp_hist,1,hist_size,hist_range);
-		normalize(temp_hist,temp_hist,255,0.0,NORM_L1);//scale to 255 for display
-
-		calcBackProject(roi_set,3,&i,temp_hist,temp_bp,hist_range);
-		int c[]={0};
-		int hs[]={BIN_NUMBER};
-		float hr[]={0,255};
-		const float* hrr[]={hr};
-		Mat hist_fore;
-		Mat hist_back;
-		calcHist(&temp_bp,1,c,mask_roi,hist_fore,1,hs,hrr);
-		calcHist(&temp_bp,1,c,inv_mask_roi,hist_back,1,hs,hrr);
-		normalize(hist_fore,hist_fore,1.0,0.0,NORM_L1);
-		normalize(hist_back,hist_back,1.0,0.0,NORM_L1);
-		//deal with gray image to get rid of #IND
-		double score=getVR(hist_back,hist_fore);
-		score=score==score ? score:0;
-		channel_score.push_back(ChannelScore(i,score));
+		for (int k=0;k<BIN_NUMBER;k++)
+			temp_hist[k]=(float)counts.back[i][k];
+		normalizeHist(temp_hist,BIN_NUMBER,255);//scale to 255 for display
+		channel_score[i]=scoreChannel(temp_hist,counts.fore[i],counts.back[i]);
 	}
 
 	//choose the 2 highest scored channels
-	channel_score.sort(compareChannel);
-	channels[0]=channel_score.back().idx;
-	channel_score.pop_back();
-	channels[1]=channel_score.back().idx;
+	chooseChannels(channel_score,channels);
 	
-	//using 2 best channel to calculate histogram
-	for (int i=0;i<2;++i)
+	//using 2 best channel to calculate histogram of the background, the 
+	//foreground pixels it does not explain are used for sampling
+	float bg_hist[BIN_NUMBER*BIN_NUMBER];
+	memset(bg_hist,0,sizeof(bg_hist));
+	for (int y=0;y<roi_win.height;y++)
 	{
-		_hRang[i][0]=0;
-		if (channels[i]==3)
-			_hRang[i][1]=179;	
-		else
-			_hRang[i][1]=255;	
-		hRange[i]=_hRang[i];
+		const uchar* b0=roi_bins[channels[0]].ptr<uchar>(y);
+		const uchar* b1=roi_bins[channels[1]].ptr<uchar>(y);
+		for (int x=0;x<roi_win.width;x++)
+			if (!body_roi.contains(Point(x,y)) && b0[x]<BIN_NUMBER && b1[x]<BIN_NUMBER)
+				bg_hist[b0[x]*BIN_NUMBER+b1[x]]++;
 	}
-	calcHist(roi_set,3,channels,inv_mask_roi,temp_hist,2,hSize,hRange);
-	normalize(temp_hist,temp_hist,255,0,NORM_L1);
-	Mat final_mask;//mask for sampling
-	calcBackProject(roi_set,3,channels,temp_hist,final_mask,hRange);
-	threshold(final_mask,final_mask,5,255,CV_THRESH_BINARY_INV);
-	          
-	final_mask=min(final_mask,mask_roi);
+	normalizeHist(bg_hist,BIN_NUMBER*BIN_NUMBER,255);
+	bool sample_bin[BIN_SLOTS*BIN_SLOTS];//mask for sampling: back-projection <=5
+	for (int i=0;i<BIN_SLOTS;i++)
+		for (int j=0;j<BIN_SLOTS;j++)
+			sample_bin[i*BIN_SLOTS+j]= i==BIN_NUMBER || j==BIN_NUMBER || saturate_cast<uchar>(bg_hist[i*BIN_NUMBER+j])<=5;
+	int sample_channels[]={channels[0],channels[1]};
 
 	//choose the best two feature space for foreground****************
-	Mat hist_fore,hist_back;
-	channel_score.clear();
-	double sum_score=0;
-	for (int i=0;i<9;i++)
+	int sample[FEATURE_CHANNEL_NUM][BIN_SLOTS];
+	memset(sample,0,sizeof(sample));
+	for (int y=fore_win.y;y<fore_win.y+fore_win.height;y++)
 	{
-		float range1[]={0,255};
-		if (i==3)
+		const uchar* b[FEATURE_CHANNEL_NUM];
+		for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+			b[c]=roi_bins[c].ptr<uchar>(y);
+		for (int x=fore_win.x;x<fore_win.x+fore_win.width;x++)
 		{
-			range1[1]=179;
+			if (!sample_bin[b[sample_channels[0]][x]*BIN_SLOTS+b[sample_channels[1]][x]])
+				continue;
+			for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+				sample[c][b[c][x]]++;
 		}
-		const float* hist_range[]={range1};
-		Mat temp_hist_neg;
-		calcHist(roi_set,3,&i,final_mask,temp_hist,1,hist_size,hist_range);
-		normalize(temp_hist,temp_hist,255,0,NORM_L1);
-		calcHist(roi_set,3,&i,inv_mask_roi,temp_hist_neg,1,hist_size,hist_range);
-		normalize(temp_hist_neg,temp_hist_neg,255,0,NORM_L1);
-		log(temp_hist,temp_hist);		
-		log(temp_hist_neg,temp_hist_neg);
-		temp_hist=temp_hist-temp_hist_neg;
-		threshold(temp_hist,temp_hist,0,255,CV_THRESH_TOZERO);
-		normalize(temp_hist,temp_hist,255,0.0,NORM_L1);//scale to 255 for display
-
-		calcBackProject(roi_set,3,&i,temp_hist,temp_bp,hist_range);
-		int c[]={0};
-		int hs[]={BIN_NUMBER};
-		float hr[]={0,255};
-		const float* hrr[]={hr};
-		calcHist(&temp_bp,1,c,final_mask,hist_fore,1,hs,hrr);
-		calcHist(&temp_bp,1,c,inv_mask_roi,hist_back,1,hs,hrr);
-		normalize(hist_fore,hist_fore,1.0,0.0,NORM_L1);
-		normalize(hist_back,hist_back,1.0,0.0,NORM_L1);
-		double score=getVR(hist_back,hist_fore);
-		score=score==score ? score:0;
-		channel_score.push_back(ChannelScore(i,score));
-		sum_score+=exp(score);
+	}
+	for (int i=0;i<FEATURE_CHANNEL_NUM;i++)
+	{
+		float temp_hist_neg[BIN_NUMBER];
+		for (int k=0;k<BIN_NUMBER;k++)
+		{
+			temp_hist[k]=(float)sample[i][k];
+			temp_hist_neg[k]=(float)counts.back[i][k];
+		}
+		normalizeHist(temp_hist,BIN_NUMBER,255);
+		normalizeHist(temp_hist_neg,BIN_NUMBER,255);
+		Mat h(BIN_NUMBER,1,CV_32FC1,temp_hist);
+		Mat h_neg(BIN_NUMBER,1,CV_32FC1,temp_hist_neg);
+		log(h,h);		
+		log(h_neg,h_neg);
+		for (int k=0;k<BIN_NUMBER;k++)
+		{
+			float d=temp_hist[k]-temp_hist_neg[k];
+			temp_hist[k]= d>0 ? d : 0;
+		}
+		normalizeHist(temp_hist,BIN_NUMBER,255);//scale to 255 for display
+		channel_score[i]=scoreChannel(temp_hist,sample[i],counts.back[i]);
 	}
 
+	chooseChannels(channel_score,channels);
 
-	channel_score.sort(compareChannel);
-	channels[0]=channel_score.back().idx;
-	channel_score.pop_back();
-	channels[1]=channel_score.back().idx;
-
-	for (int i=0;i<2;++i)
+	float fore_hist[BIN_NUMBER*BIN_NUMBER];
+	memset(fore_hist,0,sizeof(fore_hist));
+	for (int y=fore_win.y;y<fore_win.y+fore_win.height;y++)
+	{
+		const uchar* s0=roi_bins[sample_channels[0]].ptr<uchar>(y);
+		const uchar* s1=roi_bins[sample_channels[1]].ptr<uchar>(y);
+		const uchar* b0=roi_bins[channels[0]].ptr<uchar>(y);
+		const uchar* b1=roi_bins[channels[1]].ptr<uchar>(y);
+		for (int x=fore_win.x;x<fore_win.x+fore_win.width;x++)
+			if (sample_bin[s0[x]*BIN_SLOTS+s1[x]] && b0[x]<BIN_NUMBER && b1[x]<BIN_NUMBER)
+				fore_hist[b0[x]*BIN_NUMBER+b1[x]]++;
+	}
+	normalizeHist(fore_hist,BIN_NUMBER*BIN_NUMBER,255);
+	Mat(BIN_NUMBER,BIN_NUMBER,CV_32FC1,fore_hist).copyTo(hist);
+	for (int i=0;i<=BIN_NUMBER;i++)
 	{
-		_hRang[i][0]=0;
-		if (channels[i]==3)
-			_hRang[i][1]=179;	
-		else
-			_hRang[i][1]=255;	
-		hRange[i]=_hRang[i];
+		for (int j=0;j<=BIN_NUMBER;j++)
+		{
+			bool in_range= i<BIN_NUMBER && j<BIN_NUMBER;
+			_bp_table[i*(BIN_NUMBER+1)+j]= in_range ? saturate_cast<uchar>(hist.at<float>(i,j)) : 0;
+		}
 	}
-	calcHist(roi_set,3,channels,final_mask,hist,2,hSize,hRange);///////////////////
-	normalize(hist,hist,255,0,NORM_L1);
 
 	//recover the shift_vector
-	Mat backPro;
-	calcBackProject(roi_set,3,channels,hist,backPro,hRange);
-	iniWin_roi=iniWin-Point(roi_win.x,roi_win.y);
+	Mat backPro(roi_win.height,roi_win.width,CV_8UC1);
+	for (int y=0;y<roi_win.height;y++)
+	{
+		const uchar* b0=roi_bins[channels[0]].ptr<uchar>(y);
+		const uchar* b1=roi_bins[channels[1]].ptr<uchar>(y);
+		uchar* d=backPro.ptr<uchar>(y);
+		for (int x=0;x<roi_win.width;x++)
+			d[x]=_bp_table[b0[x]*(BIN_NUMBER+1)+b1[x]];
+	}
 	Point2f origin_point_roi((float)(iniWin_roi.x+0.5*iniWin_roi.width),(float)(iniWin_roi.y+0.5*iniWin_roi.height));
 	meanShift(backPro,iniWin_roi,TermCriteria( CV_TERMCRIT_EPS | CV_TERMCRIT_ITER, 10, 1 ));
 
@@ -212,54 +268,132 @@ AppTemplate::AppTemplate(const Mat* frame_set, const Rect iniWin,int ID)
 AppTemplate::AppTemplate(const AppTemplate& tracker): ID(tracker.ID)
 {
 	tracker.hist.copyTo(hist);
-	tracker.confidence_map.copyTo(confidence_map);
 	shift_vector=tracker.shift_vector;
 	score=tracker.score;
-	for (int i=0;i<2;i++)
+	channels[0]=tracker.channels[0];
+	channels[1]=tracker.channels[1];
+	memcpy(_bp_table,tracker._bp_table,sizeof(_bp_table));
+}
+
+void AppTemplate::calcBP(FrameSet* frame_set, const Mat& occ_mask, Rect occ_win, Rect ROI,Mat& confidence_map)//*******************
+{
+	AppTemplate* self=this;
+	Point no_shift(0,0);
+	calcEnsembleBP(frame_set,occ_mask,occ_win,ROI,&self,&no_shift,1,confidence_map);
+}
+
+// the part of one template's window inside the frame
+typedef struct BPSource
+{
+	const uchar* b0;//bin indices of the 2 channels
+	const uchar* b1;
+	const uchar* mask;
+	size_t bin_step;
+	size_t mask_step;
+	const uchar* table;
+	Rect win;//in map coordinates
+}BPSource;
+
+void AppTemplate::calcEnsembleBP(FrameSet* frame_set, const Mat& occ_mask, Rect occ_win, Rect ROI,
+	AppTemplate* const* templates, const Point* shifts, int n, Mat& confidence_map)
+{
+	confidence_map.create(ROI.height,ROI.width,CV_32FC1);//[0,255]
+	confidence_map.setTo(Scalar(0));
+	if (n==0)
+		return;
+
+	Rect frame_win(0,0,frame_set->cols(),frame_set->rows());
+	vector<BPSource> sources(n);
+	for (int i=0;i<n;i++)
+	{
+		Rect win=ROI+shifts[i];
+		Rect roi=frame_win & win;//the rest of the win is left zero
+
+		Mat roi_bins[FEATURE_CHANNEL_NUM];
+		frame_set->getBinRoi(roi,roi_bins);
+		const Mat& b0=roi_bins[templates[i]->channels[0]];
+		const Mat& b1=roi_bins[templates[i]->channels[1]];
+		sources[i].b0=b0.data;
+		sources[i].b1=b1.data;
+		sources[i].bin_step=b0.step;
+		sources[i].mask=occ_mask.data+(roi.y-occ_win.y)*occ_mask.step+(roi.x-occ_win.x);//1 for occupied pixels, which are left zero
+		sources[i].mask_step=occ_mask.step;
+		sources[i].table=templates[i]->_bp_table;
+		sources[i].win=roi-Point(win.x,win.y);
+	}
+
+	// one pass over the map, adding the templates in order; the same values
+	// as summing calcBackProject() of each template and dividing by n
+	float scale=(float)(1.0/n);
+	for (int y=0;y<confidence_map.rows;y++)
 	{
-		channels[i]=tracker.channels[i];
-		for (int j=0;j<2;j++)
+		float* d=confidence_map.ptr<float>(y);
+		for (int i=0;i<n;i++)
 		{
-			_hRang[i][j]=tracker._hRang[i][j];
+			const BPSource& s=sources[i];
+			int r=y-s.win.y;
+			if (r<0 || r>=s.win.height)
+				continue;
+			const uchar* b0=s.b0+r*s.bin_step;
+			const uchar* b1=s.b1+r*s.bin_step;
+			const uchar* m=s.mask+r*s.mask_step;
+			float* dst=d+s.win.x;
+			for (int x=0;x<s.win.width;x++)
+				dst[x]+= m[x] ? 0.0f : (float)s.table[b0[x]*(BIN_NUMBER+1)+b1[x]];
 		}
+		for (int x=0;x<confidence_map.cols;x++)
+			d[x]*=scale;
 	}
-	hRange[0]=_hRang[0];
-	hRange[1]=_hRang[1];
 }
-
-void AppTemplate::calcBP(const Mat* frame_set, Mat& occ_map,Rect ROI)//*******************
+static inline double boxSum(const Mat& integral, Rect r)
 {
-	confidence_map=Mat::zeros(ROI.height,ROI.width,CV_8UC1);
-	Rect frame_win(0,0,frame_set[0].cols,frame_set[0].rows);
-	Rect roi=frame_win & ROI;//the rest of the win will be filled with zero
-
-	//CAUTION: cannot generalize to other structure of feature channels
-	Mat roi_set[]={Mat(frame_set[0],roi), Mat(frame_set[1],roi),Mat(frame_set[2],roi)};
-	Mat roi_backproj(confidence_map,roi-Point(ROI.x, ROI.y));
-	Mat roi_mask(occ_map,roi);//occ_map: 1 for no occupancy, 0 for occupancy
-	calcBackProject(roi_set,3,channels,hist,roi_backproj,hRange);
-
-	roi_backproj.setTo(Scalar(0.0),roi_mask);
-	confidence_map.convertTo(confidence_map,CV_32FC1);//[0,255]
+	return integral.at<double>(r.y+r.height,r.x+r.width)-integral.at<double>(r.y,r.x+r.width)
+		-integral.at<double>(r.y+r.height,r.x)+integral.at<double>(r.y,r.x);
 }
-void AppTemplate::calcScore(Rect b_inner,Rect b_outer)//*******************
+void AppTemplate::calcScore(const Mat& confidence_map,Mat& sum,Mat& sqsum,Rect b_inner,Rect b_outer)//*******************
 {
-	Mat cm;
-	confidence_map.copyTo(cm);
-	Rect rw=b_inner&Rect(0,0,cm.cols,cm.rows);
-	Scalar fg=mean(cm(rw));//be careful with the range
-	Mat mask=Mat::zeros(confidence_map.size(),CV_8UC1);
-	rectangle(mask,b_outer,Scalar(1),-1);//mask out the whole GT
-	cm.setTo(Scalar(0),mask);
-	Mat matching_map;
 	if (confidence_map.rows==0)
 	{
 		score=0;
 		return;
 	}
-	matchTemplate(cm,Mat(b_inner.height,b_inner.width,CV_32FC1,Scalar(255)),matching_map,CV_TM_SQDIFF);
-	Point minloc;
-	minMaxLoc(matching_map,0,0,&minloc);
-	Scalar bg=mean(cm(Rect(minloc.x,minloc.y,b_inner.width,b_inner.height)));
-	score=(fg[0]-bg[0]);///fg[0];
+	integral(confidence_map,sum,sqsum,CV_64F);
+	Rect map_win(0,0,confidence_map.cols,confidence_map.rows);
+	Rect rw=b_inner&map_win;
+	double fg= rw.area()>0 ? boxSum(sum,rw)/rw.area() : 0;//be careful with the range
+
+	// the background window is the one closest to 255 (least SQDIFF against a
+	// 255 template) with the whole GT masked out; the sums of a window on the
+	// masked map are its sums minus those of its overlap with the GT
+	Rect gt=b_outer&map_win;
+	Point minloc(0,0);
+	double min_diff=DBL_MAX;
+	for (int y=0;y+b_inner.height<=confidence_map.rows;y++)
+	{
+		for (int x=0;x+b_inner.width<=confidence_map.cols;x++)
+		{
+			Rect w(x,y,b_inner.width,b_inner.height);
+			Rect overlap=w&gt;
+			double s=boxSum(sum,w);
+			double sq=boxSum(sqsum,w);
+			if (overlap.area()>0)
+			{
+				s-=boxSum(sum,overlap);
+				sq-=boxSum(sqsum,overlap);
+			}
+			double diff=sq-510*s;//SQDIFF without the constant 255*255*area
+			if (diff<min_diff)
+			{
+				min_diff=diff;
+				minloc=Point(x,y);
+			}
+		}
+	}
+	Rect bw(minloc.x,minloc.y,b_inner.width,b_inner.height);
+	Rect overlap=bw&gt;
+	double bg_sum=boxSum(sum,bw&map_win);
+	if (overlap.area()>0)
+		bg_sum-=boxSum(sum,overlap);
+	double bg= bw.area()>0 ? bg_sum/bw.area() : 0;
+	score=(fg-bg);///fg[0];
 }
\ No newline at end of file
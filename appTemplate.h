@@ -26,22 +26,21 @@
 #ifndef APP_TEMPLATE_H
 #define APP_TEMPLATE_H
 
-#include <list>
+#include <vector>
 
 #include "opencv2/opencv.hpp"
 
 #include "util.h"
 #include "parameter.h"
+#include "frameSet.h"
 
 
-#define BIN_NUMBER 32 
-static int hSize[]={BIN_NUMBER,BIN_NUMBER}; //2D histogram
-
 /*
 Appearance Template:
 Each appearance template contains a 2D histogram, which is coded by
 "int channel[2]", representing the selected channel, and "Mat hist", the
-corresponding 2D histogram.
+corresponding 2D histogram. The back-projection looks the histogram up
+through the bin index planes of the frame set.
 */
 
 
@@ -50,15 +49,21 @@ class AppTemplate
 	
 public:
 	AppTemplate(const AppTemplate& tracker);
-	AppTemplate(const Mat* frame_set,      const Rect iniWin,              int ID);
+	AppTemplate(FrameSet* frame_set,      const Rect iniWin,              int ID);
 	//						[frame in RGB,HSV,Lab]  [initial detection window]  	       
+	static Rect getRoiWin(Rect iniWin);//the region the template is learned from
 
 	// calculate back-projection map
-	void calcBP(const Mat* frame_set, Mat& occ_map,    Rect ROI); 
-	//                                                            [occupancy map]  
-	void calcScore(Rect b_inner,Rect b_outer);//all argument is relative to confidence_map roi
+	void calcBP(FrameSet* frame_set, const Mat& occ_mask, Rect occ_win, Rect ROI,        Mat& confidence_map); 
+	//                              [occupancy of occ_win, which covers ROI in the frame]   [output, CV_32FC1]
+	// average back-projection map of n templates, template i looking at ROI+shifts[i]
+	static void calcEnsembleBP(FrameSet* frame_set, const Mat& occ_mask, Rect occ_win, Rect ROI,
+		AppTemplate* const* templates, const Point* shifts, int n, Mat& confidence_map);
+	void calcScore(const Mat& confidence_map,Mat& sum,Mat& sqsum,Rect b_inner,Rect b_outer);//all argument is relative to confidence_map roi
+	//                                       [buffers for the integrals of the map]
 	
-	inline Mat& getConfidenceMap(){return confidence_map;}
+	inline const Mat& getHist(){return hist;}//BIN_NUMBER x BIN_NUMBER over channels getChannel(0) and getChannel(1)
+	inline int getChannel(int i){return channels[i];}
 	inline Point2f getShiftVector(){return shift_vector;}
 	inline double getScore(){return score;}
 	inline int getID(){return ID;}
@@ -68,10 +73,8 @@ private:
 	int channels[2];
 	Mat hist;
 
-	float _hRang[2][2];
-	const float* hRange[2];
+	unsigned char _bp_table[(BIN_NUMBER+1)*(BIN_NUMBER+1)];//hist as back-projected values, 0 for out-of-range bins
 	
-	Mat confidence_map;
 	Point2f shift_vector;
 	double score;
 };
@@ -0,0 +1,168 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include "OS_specific.h"
+#include "binDetection.h"
+
+#if OS_type==1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
+
+BinDetectionFile::BinDetectionFile(const char* filename)
+	:open_success(false),_data(NULL),_size(0),_header(NULL),_records(NULL),_offsets(NULL)
+{
+#if OS_type==1
+	int fd=open(filename,O_RDONLY);
+	if (fd<0)
+	{
+		cout<<"fail to open "<<filename<<endl;
+		return;
+	}
+	struct stat st;
+	if (fstat(fd,&st)==0 && st.st_size>=(off_t)sizeof(BinDetHeader))
+	{
+		_size=(size_t)st.st_size;
+		void* p=mmap(NULL,_size,PROT_READ,MAP_PRIVATE,fd,0);
+		if (p!=MAP_FAILED)
+		{
+			_data=(const char*)p;
+			madvise(p,_size,MADV_SEQUENTIAL);
+		}
+	}
+	close(fd);
+#else
+	// no mmap: load the whole file once
+	FILE* f=fopen(filename,"rb");
+	if (f==NULL)
+	{
+		cout<<"fail to open "<<filename<<endl;
+		return;
+	}
+	fseek(f,0,SEEK_END);
+	long len=ftell(f);
+	fseek(f,0,SEEK_SET);
+	if (len>=(long)sizeof(BinDetHeader))
+	{
+		char* buf=new char[len];
+		if (fread(buf,1,len,f)==(size_t)len)
+		{
+			_data=buf;
+			_size=(size_t)len;
+		}
+		else
+			delete [] buf;
+	}
+	fclose(f);
+#endif
+	if (_data==NULL)
+	{
+		cout<<"bad file"<<endl;
+		return;
+	}
+
+	_header=(const BinDetHeader*)_data;
+	unsigned long long table_end=_header->table_offset+((unsigned long long)_header->frame_num+1)*sizeof(unsigned long long);
+	if (memcmp(_header->magic,BIN_DET_MAGIC,4)!=0 ||
+		_header->version!=BIN_DET_VERSION ||
+		table_end>_size ||
+		sizeof(BinDetHeader)+_header->record_num*sizeof(BinDetRecord)>_header->table_offset)
+	{
+		cout<<"bad file"<<endl;
+		return;
+	}
+	_records=(const BinDetRecord*)(_data+sizeof(BinDetHeader));
+	_offsets=(const unsigned long long*)(_data+_header->table_offset);
+	open_success=true;
+}
+BinDetectionFile::~BinDetectionFile()
+{
+	if (_data==NULL)
+		return;
+#if OS_type==1
+	munmap((void*)_data,_size);
+#else
+	delete [] _data;
+#endif
+}
+const BinDetRecord* BinDetectionFile::getFrame(int frame, size_t& n) const
+{
+	n=0;
+	if (!open_success || frame<0 || frame>=(int)_header->frame_num)
+		return NULL;
+	unsigned long long begin=_offsets[frame];
+	unsigned long long end=MIN(_offsets[frame+1],_header->record_num);
+	if (begin>=end)
+		return NULL;
+	n=(size_t)(end-begin);
+	return _records+begin;
+}
+
+/* ****** ****** */
+
+BinDetectionWriter::BinDetectionWriter(const char* filename):_record_num(0)
+{
+	open_success=true;
+	_file=fopen(filename,"wb");
+	if (_file==NULL)
+	{
+		cout<<"fail to open "<<filename<<endl;
+		open_success=false;
+		return;
+	}
+	// placeholder, rewritten on close
+	BinDetHeader header;
+	memset(&header,0,sizeof(header));
+	fwrite(&header,sizeof(header),1,_file);
+}
+BinDetectionWriter::~BinDetectionWriter()
+{
+	if (_file==NULL)
+		return;
+	BinDetHeader header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,BIN_DET_MAGIC,4);
+	header.version=BIN_DET_VERSION;
+	header.frame_num=(unsigned int)_offsets.size();
+	header.record_num=_record_num;
+	header.table_offset=sizeof(BinDetHeader)+_record_num*sizeof(BinDetRecord);
+
+	_offsets.push_back(_record_num);
+	fwrite(&_offsets[0],sizeof(unsigned long long),_offsets.size(),_file);
+	fseek(_file,0,SEEK_SET);
+	fwrite(&header,sizeof(header),1,_file);
+	fclose(_file);
+}
+bool BinDetectionWriter::putNextFrameResult(const vector<BinDetRecord>& result)
+{
+	if (!open_success)
+		return false;
+	_offsets.push_back(_record_num);
+	if (!result.empty())
+		fwrite(&result[0],sizeof(BinDetRecord),result.size(),_file);
+	_record_num+=result.size();
+	return true;
+}
@@ -0,0 +1,103 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef BIN_DETECTION_H
+#define BIN_DETECTION_H
+
+#include <cstdio>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+using namespace cv;
+using namespace std;
+
+/*
+Binary Detection File:
+A compact replay format for precomputed detections. The layout is
+
+	[BinDetHeader][BinDetRecord x record_num][uint64 offset x (frame_num+1)]
+
+Records are packed frame by frame; entry f of the offset table is the index
+of the first record of frame f, and entry frame_num is record_num. The table
+is stored after the records so that the writer can stream frames of unknown
+count. The reader maps the file and hands out pointers into it.
+*/
+
+#define BIN_DET_MAGIC "HEDB"
+#define BIN_DET_VERSION 1
+
+typedef struct BinDetHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int frame_num;
+	unsigned int reserved;
+	unsigned long long record_num;
+	unsigned long long table_offset;//byte offset of the offset table
+}BinDetHeader;
+
+typedef struct BinDetRecord
+{
+	float x, y, w, h;//top-left corner, width, height
+	float score;
+	int cls;
+}BinDetRecord;
+
+class BinDetectionFile // read-only, memory mapped
+{
+public:
+	BinDetectionFile(const char* filename);
+	~BinDetectionFile();
+	inline bool getOpenSuc(){return open_success;}
+	inline int getFrameNum(){return open_success ? (int)_header->frame_num : 0;}
+	// records of a frame, n is set to their count (0 for frames out of range)
+	const BinDetRecord* getFrame(int frame, size_t& n) const;
+
+private:
+	bool open_success;
+	const char* _data;
+	size_t _size;
+	const BinDetHeader* _header;
+	const BinDetRecord* _records;
+	const unsigned long long* _offsets;
+};
+
+class BinDetectionWriter
+{
+public:
+	BinDetectionWriter(const char* filename);
+	~BinDetectionWriter();//writes the offset table and the final header
+	bool putNextFrameResult(const vector<BinDetRecord>& result);
+	inline bool getOpenSuc(){return open_success;}
+
+private:
+	FILE* _file;
+	bool open_success;
+	vector<unsigned long long> _offsets;
+	unsigned long long _record_num;
+};
+
+#endif
@@ -77,96 +77,233 @@ void ImageDataReader::readImg(Mat& frame)
 	frame=imread(_directory+_m_fileNames[_file_counter]);
 	_file_counter++;
 }
+void ImageDataReader::readImgAt(int n, Mat& frame)
+{
+	if (n<0 || n>=(int)_m_fileNames.size())
+	{
+		frame=Mat();
+		return;
+	}
+	frame=imread(_directory+_m_fileNames[n]);
+}
 
 /* ****** ****** */
 
-XMLBBoxReader::XMLBBoxReader(const char* filename)
+PrefetchReader::PrefetchReader(SeqReader* reader, int ring_size, int thread_num)
+	:_reader(reader),
+	_frame_num(reader->getFrameNum()),
+	_ring(MAX(ring_size,1)),
+	_next_load(0),
+	_next_read(0),
+	_next_release(0),
+	_stop(false)
+{
+	for (size_t i=0;i<_ring.size();i++)
+	{
+		_ring[i].state=FREE;
+		_ring[i].index=(int)i;
+	}
+	// a sequential reader has to be read by one thread
+	int n=_frame_num<0 ? 1:MAX(MIN(thread_num,(int)_ring.size()),1);
+	for (int i=0;i<n;i++)
+		_decoders.push_back(std::thread(&PrefetchReader::decode,this));
+}
+PrefetchReader::~PrefetchReader()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop=true;
+	}
+	_changed.notify_all();
+	for (size_t i=0;i<_decoders.size();i++)
+		_decoders[i].join();
+}
+void PrefetchReader::decode()
+{
+	for (;;)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (_stop || (_frame_num>=0 && _next_load>=_frame_num))
+			return;
+		int n=_next_load++;
+		Slot& slot=_ring[n%_ring.size()];
+		while (!_stop && !(slot.state==FREE && slot.index==n))
+			_changed.wait(lock);
+		if (_stop)
+			return;
+		slot.state=LOADING;
+		lock.unlock();
+
+		if (_frame_num>=0)
+			_reader->readImgAt(n,slot.frame);
+		else if (_reader->reusesBuffer())
+		{
+			// copied out, the next read overwrites the frame; copyTo() keeps the slot's allocation
+			Mat decoded;
+			_reader->readImg(decoded);
+			if (decoded.data!=NULL)
+				decoded.copyTo(slot.frame);
+			else
+				slot.frame=Mat();
+		}
+		else
+			_reader->readImg(slot.frame);
+
+		lock.lock();
+		slot.state=READY;
+		_changed.notify_all();
+		if (slot.frame.data==NULL)
+		{
+			_next_load=_frame_num=n;//end of the sequence, the other decoders stop
+			return;
+		}
+	}
+}
+void PrefetchReader::readImg(Mat& frame)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (_frame_num>=0 && _next_read>=_frame_num)
+	{
+		frame=Mat();
+		return;
+	}
+	Slot& slot=_ring[_next_read%_ring.size()];
+	while (!(slot.state==READY && slot.index==_next_read))
+		_changed.wait(lock);
+	frame=slot.frame;
+	if (frame.data==NULL)
+		return;//the end, the slot stays as it is
+	slot.state=IN_USE;
+	_next_read++;
+}
+void PrefetchReader::releaseImg(Mat& frame)
+{
+	frame.release();
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_next_release>=_next_read)
+		return;
+	Slot& slot=_ring[_next_release%_ring.size()];
+	slot.state=FREE;
+	slot.index=_next_release+(int)_ring.size();
+	_next_release++;
+	_changed.notify_all();
+}
+
+/* ****** ****** */
+
+XMLFrameReader::XMLFrameReader(const char* filename):at_frame(false)
 {
 	open_success=true;
-	file=xmlReadFile(filename,"UTF-8",XML_PARSE_RECOVER);
-	if (file == NULL)
+	reader=xmlReaderForFile(filename,"UTF-8",XML_PARSE_RECOVER);
+	if (reader == NULL)
 	{
 		cout<<"fail to open"<<endl;
 		open_success=false;
+		return;
 	}
-	if (open_success)
+	// move to the root element
+	int ret=xmlTextReaderRead(reader);
+	while (ret==1 && xmlTextReaderNodeType(reader)!=XML_READER_TYPE_ELEMENT)
+		ret=xmlTextReaderRead(reader);
+	if (ret!=1)
 	{
-		frame=xmlDocGetRootElement(file);
-		if (frame==NULL)
-		{
-			cout<<"empty file"<<endl;
-			open_success=false;
-		}
-		if (xmlStrcmp(frame->name,BAD_CAST"dataset"))
+		cout<<"empty file"<<endl;
+		open_success=false;
+		return;
+	}
+	if (xmlStrcmp(xmlTextReaderConstName(reader),BAD_CAST"dataset"))
+	{
+		cout<<"bad file"<<endl;
+		open_success=false;
+	}
+}
+xmlNodePtr XMLFrameReader::nextFrame()
+{
+	if (!open_success)
+		return NULL;
+	// skip the subtree of the last frame, or step into the root the first time
+	int ret= at_frame ? xmlTextReaderNext(reader) : xmlTextReaderRead(reader);
+	at_frame=false;
+	while (ret==1)
+	{
+		int depth=xmlTextReaderDepth(reader);
+		if (depth<1)
+			break;//end of the root
+		if (depth==1 && xmlTextReaderNodeType(reader)==XML_READER_TYPE_ELEMENT)
 		{
-			cout<<"bad file"<<endl;
-			open_success=false;
+			if (!xmlStrcmp(xmlTextReaderConstName(reader),BAD_CAST"frame"))
+			{
+				at_frame=true;
+				return xmlTextReaderExpand(reader);
+			}
+			ret=xmlTextReaderNext(reader);//skip unknown elements
+			continue;
 		}
-		frame=frame->children;
-	}				
+		ret=xmlTextReaderRead(reader);
+	}
+	return NULL;
 }
+
+/* ****** ****** */
+
 bool XMLBBoxReader::getNextFrameResult(vector<Result2D>& result)
 {
-	bool rt=false;
 	result.clear();
-	while (frame!=NULL)
+	xmlNodePtr frame=reader.nextFrame();
+	if (frame==NULL)
+		return false;
+
+	xmlNodePtr objectList;
+	objectList=frame->children;
+	while (objectList!=NULL)//objectlist level
 	{
-		if (!xmlStrcmp(frame->name,BAD_CAST"frame"))
+		if (!xmlStrcmp(objectList->name,BAD_CAST"objectlist"))
 		{
-			rt=true;//get the successive frame
-			xmlNodePtr objectList;
-			objectList=frame->children;
-			while (objectList!=NULL)//objectlist level
+			xmlNodePtr object=objectList->children;
+			while (object!=NULL)//object level
 			{
-				if (!xmlStrcmp(objectList->name,BAD_CAST"objectlist"))
+				if (!xmlStrcmp(object->name,BAD_CAST"object"))
 				{
-					xmlNodePtr object=objectList->children;
-					while (object!=NULL)//object level
+					Result2D res;
+					temp=xmlGetProp(object,BAD_CAST"id");
+					res.id=string2int((char*)temp);
+					xmlFree(temp);
+					temp=xmlGetProp(object,BAD_CAST"confidence");
+					if (temp!=NULL)
 					{
-						if (!xmlStrcmp(object->name,BAD_CAST"object"))
+						res.response=string2float((char*)temp);
+						xmlFree(temp);
+					}
+					xmlNodePtr box=object->children;
+					while (box!=NULL)
+					{
+						if (!xmlStrcmp(box->name,BAD_CAST"box"))
 						{
-							Result2D res;
-							temp=xmlGetProp(object,BAD_CAST"id");
-							res.id=string2int((char*)temp);
+							temp=xmlGetProp(box,BAD_CAST"h");
+							res.h=(float)string2float((char*)temp);
+							xmlFree(temp);
+							temp=xmlGetProp(box,BAD_CAST"w");
+							res.w=(float)string2float((char*)temp);
+							xmlFree(temp);
+							temp=xmlGetProp(box,BAD_CAST"xc");
+							res.xc=(float)string2float((char*)temp);
+							xmlFree(temp);
+							temp=xmlGetProp(box,BAD_CAST"yc");
+							res.yc=(float)string2float((char*)temp);
 							xmlFree(temp);
-							xmlNodePtr box=object->children;
-							while (box!=NULL)
-							{
-								if (!xmlStrcmp(box->name,BAD_CAST"box"))
-								{
-									temp=xmlGetProp(box,BAD_CAST"h");
-									res.h=(float)string2float((char*)temp);
-									xmlFree(temp);
-									temp=xmlGetProp(box,BAD_CAST"w");
-									res.w=(float)string2float((char*)temp);
-									xmlFree(temp);
-									temp=xmlGetProp(box,BAD_CAST"xc");
-									res.xc=(float)string2float((char*)temp);
-									xmlFree(temp);
-									temp=xmlGetProp(box,BAD_CAST"yc");
-									res.yc=(float)string2float((char*)temp);
-									xmlFree(temp);
-									break;
-								}
-								box=box->next;
-							}
-							result.push_back(res);
+							break;
 						}
-						object=object->next;
+						box=box->next;
 					}
-					break;
-				}	
-				objectList=objectList->next;
+					result.push_back(res);
+				}
+				object=object->next;
 			}
 			break;
-		}
-		frame=frame->next;
+		}	
+		objectList=objectList->next;
 	}
-	if (frame!=NULL)
-	{
-		frame=frame->next;
-	}		
-	return rt;
+	return true;
 }	
 
 /* ****** ****** */
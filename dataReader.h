@@ -28,9 +28,13 @@
 
 #include <cstdio>
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "libxml/parser.h"
 #include "libxml/tree.h"
+#include "libxml/xmlreader.h"
 #include "libxml/encoding.h"
 #include "libxml/xmlwriter.h"
 #include "opencv2/opencv.hpp"
@@ -51,14 +55,19 @@ typedef struct Result2D
 	double response;
 	Result2D(int i,float x_,float y_,float w_,float h_,double res=1)
 		:id(i),xc(x_),yc(y_),w(w_),h(h_),response(res){}
-	Result2D(){}
+	Result2D():id(0),xc(0),yc(0),w(0),h(0),response(1){}
 }Result2D;
 
 class SeqReader //sequence reader interface
 {
 public:
 	SeqReader(){};
+	virtual ~SeqReader(){}
 	virtual void readImg(Mat& frame)=0;
+	virtual void releaseImg(Mat& frame){}//hand back the oldest frame from readImg once it is not used any more
+	virtual int getFrameNum(){return -1;}//number of frames, -1 if the sequence can only be read in order
+	virtual void readImgAt(int n, Mat& frame){}//frame n; safe to call from several threads when getFrameNum()>=0
+	virtual bool reusesBuffer(){return false;}//true if the next readImg() overwrites the pixels of the last frame
 };
 
 class BBoxReader // interface for reading bounding boxes from files
@@ -80,6 +89,7 @@ class VideoReader:public SeqReader
 public:
 	VideoReader(const string filename):capture(filename){}
 	virtual void readImg(Mat& frame){	capture>>frame;}
+	virtual bool reusesBuffer(){return true;}//the capture decodes into its own buffer
 
 private:
 	VideoCapture capture;
@@ -90,6 +100,8 @@ class ImageDataReader:public SeqReader
 public:
 	ImageDataReader(const string dir);
 	virtual void readImg(Mat& frame);
+	virtual int getFrameNum(){return (int)_m_fileNames.size();}
+	virtual void readImgAt(int n, Mat& frame);
 
 private:
 	int _file_counter;
@@ -97,22 +109,82 @@ private:
 	vector<string> _m_fileNames;
 };
 
-class XMLBBoxReader:public BBoxReader
+/*
+Prefetch Reader:
+Reads frames ahead of the consumer into a ring of ring_size slots. A reader
+with random access (ImageDataReader) is decoded by thread_num threads, any
+other one by a single thread in order. readImg() hands out the slot's Mat
+without copying; the consumer gives it back with releaseImg(), in the order
+the frames were read, and the slot is then refilled with the next frame.
+Frames of a reader that reuses its buffer (VideoReader) are copied into the
+slot's own buffer, which is allocated once. The wrapped reader is not owned.
+*/
+class PrefetchReader:public SeqReader
+{
+public:
+	PrefetchReader(SeqReader* reader, int ring_size, int thread_num=1);
+	~PrefetchReader();
+	virtual void readImg(Mat& frame);
+	virtual void releaseImg(Mat& frame);
+
+private:
+	enum SlotState {FREE, LOADING, READY, IN_USE};
+	typedef struct Slot
+	{
+		Mat frame;
+		SlotState state;
+		int index;//the frame the slot is for
+	}Slot;
+
+	void decode();
+
+	SeqReader* _reader;
+	int _frame_num;
+	vector<Slot> _ring;
+	int _next_load;
+	int _next_read;
+	int _next_release;
+	bool _stop;
+	std::mutex _mutex;
+	std::condition_variable _changed;
+	vector<std::thread> _decoders;
+};
+
+/*
+XML Frame Reader:
+Streams the <frame> elements under the <dataset> root of a detection/result
+xml file with libxml2's xmlTextReader. Only the current frame is expanded into
+a DOM subtree, so memory stays bounded whatever the length of the sequence.
+*/
+class XMLFrameReader
 {
 public:
-	XMLBBoxReader(const char* filename);	
-	~XMLBBoxReader()
+	XMLFrameReader(const char* filename);
+	~XMLFrameReader()
 	{
-		xmlFreeDoc(file);
+		if (reader!=NULL)
+			xmlFreeTextReader(reader);
 	}
 	inline bool getOpenSuc(){return open_success;}
+	// the next <frame> node, NULL at the end; valid until the next call
+	xmlNodePtr nextFrame();
+
+private:
+	xmlTextReaderPtr reader;
+	bool open_success;
+	bool at_frame;//the reader stands on an expanded frame
+};
+
+class XMLBBoxReader:public BBoxReader
+{
+public:
+	XMLBBoxReader(const char* filename):reader(filename){}
+	inline bool getOpenSuc(){return reader.getOpenSuc();}
 	virtual bool getNextFrameResult(vector<Result2D>& result);
 
 private:
-	xmlDocPtr file;
-	xmlNodePtr frame;
+	XMLFrameReader reader;
 	xmlChar* temp;
-	bool open_success;
 };
 #define  ENCODING "UTF-8"
 class XMLBBoxWriter: public BBoxWriter
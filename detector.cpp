@@ -35,38 +35,11 @@ void Detector::draw(Mat& frame)
 
 /* ****** ****** */
 
-XMLDetector::XMLDetector(const char* filename):Detector(XML)
-{
-	open_success=true;
-	file=xmlReadFile(filename,"UTF-8",XML_PARSE_RECOVER);
-	{
-		cout<<"fasetSVMDetector(detector);il to open"<<endl;
-		open_success=false;
-	}
-	if (open_success)
-	{
-		frame=xmlDocGetRootElement(file);
-		if (frame==NULL)
-		{
-			cout<<"empty file"<<endl;
-			open_success=false;
-		}
-		if (xmlStrcmp(frame->name,BAD_CAST"dataset"))
-		{
-			cout<<"bad file"<<endl;
-			open_success=false;
-		}
-		frame=frame->children;
-		while (xmlStrcmp(frame->name,BAD_CAST"frame"))
-		{
-			frame=frame->next;
-		}			
-	}	
-}
 void XMLDetector::detect(const Mat& f, int gpu)
 {
 	detection.clear();
 	response.clear();
+	xmlNodePtr frame=reader.nextFrame();
 	if (frame!=NULL)
 	{
 		xmlNodePtr objectList=frame->children;
@@ -111,21 +84,162 @@ void XMLDetector::detect(const Mat& f, int gpu)
 			}
 		}
 	}		
-	if (frame!=NULL)
+}
+
+/* ****** ****** */
+
+DetectionSource::DetectionSource(const char* filename, bool use_index)
+	:Detector(TXT),
+	_filename(filename),
+	_use_index(use_index),
+	_frame_idx(0),
+	_has_pending(false),
+	_pending_frame(0),
+	_pending_conf(1)
+{
+	open_success=true;
+	_file.open(filename);
+	if (!_file.is_open())
+	{
+		cout<<"fail to open "<<filename<<endl;
+		open_success=false;
+		return;
+	}
+	readRecord();
+}
+bool DetectionSource::readRecord()
+{
+	_has_pending=false;
+	string line;
+	while (getline(_file,line))
+	{
+		int f,x1,y1,x2,y2;
+		double c=1;
+		if (sscanf(line.c_str(),"%d %d %d %d %d %lf",&f,&x1,&y1,&x2,&y2,&c)<5)
+			continue;//blank or broken line
+		_pending_frame=f;
+		_pending_box=Rect(Point(x1,y1),Point(x2,y2));
+		_pending_conf=c;
+		_has_pending=true;
+		break;
+	}
+	return _has_pending;
+}
+void DetectionSource::detect(const Mat& f, int gpu)
+{
+	detection.clear();
+	response.clear();
+	// skip records of frames already passed (only happens for unsorted files)
+	while (_has_pending && _pending_frame<_frame_idx)
+		readRecord();
+	while (_has_pending && _pending_frame==_frame_idx)
+	{
+		detection.push_back(_pending_box);
+		response.push_back(_pending_conf);
+		readRecord();
+	}
+	_frame_idx++;
+}
+bool DetectionSource::seek(int frame_n)
+{
+	if (!open_success)
+		return false;
+	if (_use_index && _index.empty())
+		loadIndex();
+
+	_file.clear();
+	if (!_index.empty())
 	{
-		frame=frame->next;
+		vector<pair<int,streamoff> >::iterator it=lower_bound(
+			_index.begin(),_index.end(),make_pair(frame_n,(streamoff)0));
+		if (it==_index.end())
+			_has_pending=false;//no detection from here on
+		else
+		{
+			_file.seekg(it->second);
+			readRecord();
+		}
+	}
+	else
+	{
+		// no index: rewind if needed and skip forward
+		if (frame_n<_frame_idx)
+		{
+			_file.seekg(0);
+			readRecord();
+		}
+		while (_has_pending && _pending_frame<frame_n)
+			readRecord();
+	}
+	_frame_idx=frame_n;
+	return true;
+}
+void DetectionSource::loadIndex()
+{
+	string idx_name=_filename+".idx";
+	ifstream idx_file(idx_name.c_str());
+	if (idx_file.is_open())
+	{
+		int f;
+		long long offset;
+		while (idx_file>>f>>offset)
+			_index.push_back(make_pair(f,(streamoff)offset));
+		return;
 	}
-	while (frame!=NULL && xmlStrcmp(frame->name,BAD_CAST"frame"))
+	buildIndex();
+
+	ofstream out(idx_name.c_str());
+	if (!out.is_open())
+		return;//the index stays in memory only
+	for (size_t i=0;i<_index.size();i++)
+		out<<_index[i].first<<" "<<(long long)_index[i].second<<endl;
+}
+void DetectionSource::buildIndex()
+{
+	ifstream in(_filename.c_str());
+	string line;
+	int last_frame=-1;
+	streamoff offset=0;
+	while (getline(in,line))
 	{
-		frame=frame->next;
+		int f;
+		if (sscanf(line.c_str(),"%d",&f)==1 && f>last_frame)
+		{
+			_index.push_back(make_pair(f,offset));
+			last_frame=f;
+		}
+		offset=in.tellg();
 	}
 }
 
 /* ****** ****** */
 
+void BinDetector::detect(const Mat& f, int gpu)
+{
+	detection.clear();
+	response.clear();
+	size_t n;
+	const BinDetRecord* rec=file.getFrame(_frame_idx,n);
+	for (size_t i=0;i<n;i++)
+	{
+		// round the same way as XMLDetector, which works on the box center
+		Rect res;
+		res.width=(int)(rec[i].w+0.5);
+		res.height=(int)(rec[i].h+0.5);
+		res.x=(int)(rec[i].x+0.5*rec[i].w-0.5*res.width+0.5);
+		res.y=(int)(rec[i].y+0.5*rec[i].h-0.5*res.height+0.5);
+		detection.push_back(res);
+		response.push_back(rec[i].score);
+	}
+	_frame_idx++;
+}
+
+/* ****** ****** */
+
 HogDetector::HogDetector():Detector(HOG),cpu_hog(Size(64,128), Size(16, 16), Size(8, 8), Size(8, 8), 9, 1, -1, 
 	HOGDescriptor::L2Hys, 0.2, false, cv::HOGDescriptor::DEFAULT_NLEVELS), 
-	gpu_hog(Size(64,128), Size(16,16), Size(8,8), Size(8,8), 9)
+	gpu_hog(Size(64,128), Size(16,16), Size(8,8), Size(8,8), 9),
+	_pool(MAX(HOG_THREAD_NUM,1))
 {
 	detector = HOGDescriptor::getDefaultPeopleDetector();
 	cpu_hog.setSVMDetector(detector);
@@ -134,16 +248,13 @@ HogDetector::HogDetector():Detector(HOG),cpu_hog(Size(64,128), Size(16, 16), Siz
 void HogDetector::detect(const Mat& frame, int gpu)
 {
 clock_t t1 = clock();
-	if (gpu) {
-            gpu::GpuMat g_frame, n_frame;
-	    g_frame.upload(frame);
-	    //cpu_hog.detectMultiScale(frame, detection, response, 0.0, Size(8,8),Size(0, 0), 1.05, 2);//-0.2
-            cv::gpu::cvtColor(g_frame, n_frame, CV_BGR2GRAY);
-	    gpu_hog.detectMultiScale(n_frame, detection);
-        }
-	else {
-	    cpu_hog.detectMultiScale(frame, detection, response, 0.0, Size(8,8),Size(0, 0), 1.05, 2);
-	}
+	detection.clear();
+	response.clear();
+	vector<Rect> crops=getCrops(frame.size());
+	if (crops.empty())
+		detectIn(frame,Point(0,0),gpu);
+	for (size_t i=0;i<crops.size();i++)
+		detectIn(Mat(frame,crops[i]),crops[i].tl(),gpu);
 
 	for (vector<Rect>::iterator it=detection.begin(); it<detection.end(); it++)
 	{
@@ -155,3 +266,246 @@ clock_t t1 = clock();
 clock_t t2 = clock();
 double elapsed_time = (t2 - t1) / (CLOCKS_PER_SEC/1000);
 }
+vector<Rect> HogDetector::getCrops(Size frame_size)
+{
+	vector<Rect> crops;
+	Rect frame_rect(0,0,frame_size.width,frame_size.height);
+	Size win=cpu_hog.winSize;
+	for (size_t i=0;i<_regions.size();i++)
+	{
+		Rect r=_regions[i];
+		r=Rect((int)(r.x*HOG_DETECT_FRAME_RATIO),(int)(r.y*HOG_DETECT_FRAME_RATIO),
+			(int)(r.width*HOG_DETECT_FRAME_RATIO),(int)(r.height*HOG_DETECT_FRAME_RATIO));
+		// grow to hold at least one detection window
+		if (r.width<win.width)
+			r=Rect(r.x-(win.width-r.width)/2,r.y,win.width,r.height);
+		if (r.height<win.height)
+			r=Rect(r.x,r.y-(win.height-r.height)/2,r.width,win.height);
+		r&=frame_rect;
+		if (r.width>=win.width && r.height>=win.height)
+			crops.push_back(r);
+	}
+
+	// merge overlapping crops until they are disjoint, so no area is searched twice
+	bool merged=true;
+	while (merged)
+	{
+		merged=false;
+		for (size_t i=0;i<crops.size() && !merged;i++)
+		{
+			for (size_t j=i+1;j<crops.size();j++)
+			{
+				if ((crops[i]&crops[j]).area()>0)
+				{
+					crops[i]|=crops[j];
+					crops.erase(crops.begin()+j);
+					merged=true;
+					break;
+				}
+			}
+		}
+	}
+
+	// a single pass is cheaper than crops covering most of the frame
+	int area=0;
+	for (size_t i=0;i<crops.size();i++)
+		area+=crops[i].area();
+	if (area>0.7*frame_rect.area())
+		crops.clear();
+	return crops;
+}
+void HogDetector::detectIn(const Mat& img, Point offset, int gpu)
+{
+	vector<Rect> found;
+	vector<double> weights;
+	if (gpu) {
+            gpu::GpuMat g_frame, n_frame;
+	    g_frame.upload(img);
+	    //cpu_hog.detectMultiScale(frame, detection, response, 0.0, Size(8,8),Size(0, 0), 1.05, 2);//-0.2
+            cv::gpu::cvtColor(g_frame, n_frame, CV_BGR2GRAY);
+	    gpu_hog.detectMultiScale(n_frame, found);
+        }
+	else if (_pool.size()>1) {
+	    detectParallel(img, found, weights);
+	}
+	else {
+	    cpu_hog.detectMultiScale(img, found, weights, 0.0, Size(8,8),Size(0, 0), 1.05, 2);
+	}
+
+	for (size_t i=0;i<found.size();i++)
+		detection.push_back(found[i]+offset);
+	response.insert(response.end(),weights.begin(),weights.end());
+}
+void HogDetector::detectParallel(const Mat& img, vector<Rect>& found, vector<double>& weights)
+{
+	// the search of detectMultiScale(img,found,weights,0.0,Size(8,8),Size(0,0),1.05,2)
+	const double scale0=1.05;
+	const Size stride(8,8);
+	Size win=cpu_hog.winSize;
+
+	// pyramid scales, as detectMultiScale chooses them
+	vector<double> level_scale;
+	double scale=1.;
+	int levels;
+	for (levels=0;levels<cpu_hog.nlevels;levels++)
+	{
+		level_scale.push_back(scale);
+		if (cvRound(img.cols/scale)<win.width || cvRound(img.rows/scale)<win.height)
+			break;
+		scale*=scale0;
+	}
+	level_scale.resize(MAX(levels,1));
+
+	// the first level is the image itself, the others live in the reused buffers;
+	// like detectMultiScale, the image is rewrapped so that the gradients of a
+	// crop (see detectIn()) do not read the frame around it
+	if (_level_buf.size()<level_scale.size())
+		_level_buf.resize(level_scale.size());
+	vector<Mat> level_img(level_scale.size());
+	for (size_t i=0;i<level_scale.size();i++)
+	{
+		Size sz(cvRound(img.cols/level_scale[i]),cvRound(img.rows/level_scale[i]));
+		if (sz==img.size())
+		{
+			level_img[i]=Mat(img.size(),img.type(),img.data,img.step);
+			continue;
+		}
+		size_t bytes=sz.area()*img.elemSize();
+		if (_level_buf[i].total()<bytes)
+			_level_buf[i].create(1,(int)bytes,CV_8UC1);
+		level_img[i]=Mat(sz,img.type(),_level_buf[i].data);
+	}
+	_pool.parallelFor((int)level_img.size(),[&](int i)
+	{
+		if (level_img[i].data!=img.data)
+			resize(img,level_img[i],level_img[i].size());
+	});
+
+	// cut the levels into tiles of about the same number of window rows; the
+	// tiles start on the window stride and overlap by a window height less one
+	// stride, so every window position is searched exactly once
+	int chunk=MAX(1,((img.rows-win.height)/stride.height+1)/(2*_pool.size()));
+	vector<HogTile> tiles;
+	for (size_t l=0;l<level_img.size();l++)
+	{
+		if (level_img[l].cols<win.width || level_img[l].rows<win.height)
+			continue;
+		int rows=(level_img[l].rows-win.height)/stride.height+1;
+		for (int r=0;r<rows;r+=chunk)
+		{
+			HogTile t;
+			t.level=(int)l;
+			t.roi=Rect(0,r*stride.height,level_img[l].cols,(MIN(chunk,rows-r)-1)*stride.height+win.height);
+			tiles.push_back(t);
+		}
+	}
+	vector<vector<Point> > hits(tiles.size());
+	vector<vector<double> > hit_weights(tiles.size());
+	_pool.parallelFor((int)tiles.size(),[&](int i)
+	{
+		// a ROI view, so the gradients at the tile border see the pixels around it
+		Mat tile(level_img[tiles[i].level],tiles[i].roi);
+		cpu_hog.detect(tile,hits[i],hit_weights[i],0.0,stride,Size(0,0));
+	});
+
+	// collect in level and tile order so that the grouping is deterministic;
+	// as with detectMultiScale, the weights are those of the ungrouped hits
+	found.clear();
+	weights.clear();
+	for (size_t i=0;i<tiles.size();i++)
+	{
+		double s=level_scale[tiles[i].level];
+		Size scaled_win(cvRound(win.width*s),cvRound(win.height*s));
+		for (size_t j=0;j<hits[i].size();j++)
+		{
+			Point p=hits[i][j]+tiles[i].roi.tl();
+			found.push_back(Rect(Point(cvRound(p.x*s),cvRound(p.y*s)),scaled_win));
+			weights.push_back(hit_weights[i][j]);
+		}
+	}
+	groupRectangles(found,2,0.2);
+}
+
+/* ****** ****** */
+
+AsyncDetector::AsyncDetector(SeqReader* reader, Detector* detector, int queue_size, int gpu)
+	:Detector(ASYNC),
+	_reader(reader),
+	_detector(detector),
+	_gpu(gpu),
+	_queue(queue_size)
+{
+	_worker=std::thread(&AsyncDetector::work,this);
+}
+AsyncDetector::~AsyncDetector()
+{
+	_queue.close();//the worker stops at its next push
+	// hand back the frames still held, a prefetching reader may block the worker otherwise
+	if (_current.frame.data!=NULL)
+		_reader->releaseImg(_current.frame);
+	DetectedFrame d;
+	while (_queue.pop(d))
+	{
+		if (d.frame.data!=NULL)
+			_reader->releaseImg(d.frame);
+	}
+	_worker.join();
+}
+void AsyncDetector::work()
+{
+	for (int frame_n=0;;frame_n++)
+	{
+		DetectedFrame d;
+		_reader->readImg(d.frame);
+		// the frame stays queued while the next ones are read, so it must have its own pixels
+		if (_reader->reusesBuffer() && d.frame.data!=NULL)
+			d.frame=d.frame.clone();
+		// the adaptive schedule is decided by the tracker, so every frame is detected then
+		if (d.frame.data!=NULL && !ADAPTIVE_DETECTION_INTERVAL && !isDetectionFrame(frame_n))
+			_detector->skip();
+		else if (d.frame.data!=NULL)
+		{
+			{
+				std::lock_guard<std::mutex> lock(_regions_mutex);
+				_detector->setSearchRegions(_regions);
+			}
+			Mat frame_resize;
+			if (_detector->needsFrame())
+				resize(d.frame,frame_resize,
+					Size((int)(d.frame.cols*HOG_DETECT_FRAME_RATIO),
+					(int)(d.frame.rows*HOG_DETECT_FRAME_RATIO)));
+			_detector->detect(frame_resize,_gpu);
+			d.detection=_detector->getDetection();
+			d.response=_detector->getResponse();
+		}
+		if (!_queue.push(d))
+		{
+			if (d.frame.data!=NULL)
+				_reader->releaseImg(d.frame);
+			break;
+		}
+		if (d.frame.data==NULL)
+			break;
+	}
+}
+void AsyncDetector::readImg(Mat& frame)
+{
+	if (!_queue.pop(_current))
+		_current=DetectedFrame();
+	frame=_current.frame;
+}
+void AsyncDetector::releaseImg(Mat& frame)
+{
+	frame.release();
+	_reader->releaseImg(_current.frame);//frames leave the queue in the order they were read
+}
+void AsyncDetector::detect(const Mat& frame, int gpu)
+{
+	detection=_current.detection;
+	response=_current.response;
+}
+void AsyncDetector::setSearchRegions(const vector<Rect>& regions)
+{
+	std::lock_guard<std::mutex> lock(_regions_mutex);
+	_regions=regions;
+}
@@ -26,21 +26,36 @@
 #ifndef DETECTOR_H
 #define DETECTOR_H
 
+#include <fstream>
+#include <thread>
+
 #include "opencv2/opencv.hpp"
 #include "opencv2/gpu/gpu.hpp"
 
 #include "util.h"
 #include "dataReader.h"
+#include "binDetection.h"
+#include "threadUtil.h"
 #include "parameter.h"
 
 #define HOG 1
 #define XML 2
+#define TXT 3
+#define BIN 4
+#define ASYNC 5
+
+// whether the fixed detection schedule runs the detector on frame_n (see DETECTION_INTERVAL)
+inline bool isDetectionFrame(int frame_n){return frame_n%MAX(DETECTION_INTERVAL,1)==0;}
 
 class Detector
 {
 public:
 	Detector(int t):type(t){}
+	virtual ~Detector(){}
 	virtual void detect(const Mat& frame, int gpu)=0;
+	virtual bool needsFrame(){return false;}//false if detect() ignores the frame
+	virtual void skip(){detection.clear();response.clear();}//pass a frame without detecting on it
+	virtual void setSearchRegions(const vector<Rect>& regions){}//areas of the next frames worth detecting on (frame coordinates), empty for the whole frame
 	inline vector<Rect> getDetection(){return detection;}
 	inline vector<double> getResponse(){return response;}
 	void draw(Mat& frame);
@@ -51,36 +66,150 @@ protected:
 	int type;
 };
 
-class XMLDetector:public Detector
+class XMLDetector:public Detector // streams one <frame> per detect() call (see XMLFrameReader)
 {
-	xmlDocPtr file;
-	xmlNodePtr frame;
+	XMLFrameReader reader;
 	xmlChar* temp;
-	bool open_success;
 public:
-	XMLDetector(const char* filename);
-	~XMLDetector()
-	{
-		xmlFreeDoc(file);
-		xmlCleanupParser();
-		xmlMemoryDump();
-	}
+	XMLDetector(const char* filename):Detector(XML),reader(filename){}
+	inline bool getOpenSuc(){return reader.getOpenSuc();}
 	virtual void detect(const Mat& f, int gpu);
+	virtual void skip(){Detector::skip();reader.nextFrame();}
+};
+
+/*
+Detection Source:
+Reads precomputed detections from a text file with one box per line,
+	<frame> <x1> <y1> <x2> <y2> [confidence]
+sorted by frame number (e.g. darknet's "det.txt"). The file is opened once
+and read through a cursor, so each detect() call only costs the boxes of the
+current frame. For random access, seek() uses a "<file>.idx" sidecar mapping
+frame numbers to byte offsets, which is built on the first seek if missing.
+*/
+class DetectionSource:public Detector
+{
+public:
+	DetectionSource(const char* filename, bool use_index=true);
+	virtual void detect(const Mat& f, int gpu);//the frame is ignored
+	virtual void skip(){Detector::skip();_frame_idx++;}
+	bool seek(int frame_n);//the next detect() returns the boxes of frame_n
+	inline bool getOpenSuc(){return open_success;}
+	inline bool isExhausted(){return !_has_pending;}
+	inline int getFrameIdx(){return _frame_idx;}
+
+private:
+	bool readRecord();
+	void loadIndex();
+	void buildIndex();
+
+	ifstream _file;
+	string _filename;
+	bool open_success;
+	bool _use_index;
+	int _frame_idx;//frame returned by the next detect()
+
+	// the record under the cursor
+	bool _has_pending;
+	int _pending_frame;
+	Rect _pending_box;
+	double _pending_conf;
+
+	vector<pair<int,streamoff> > _index;//frame -> offset of its first line
 };
 
+class BinDetector:public Detector // replays a binary detection file (see binDetection.h)
+{
+public:
+	BinDetector(const char* filename):Detector(BIN),file(filename),_frame_idx(0){}
+	virtual void detect(const Mat& f, int gpu);
+	virtual void skip(){Detector::skip();_frame_idx++;}
+	inline void seek(int frame_n){_frame_idx=frame_n;}
+	inline bool getOpenSuc(){return file.getOpenSuc();}
+
+private:
+	BinDetectionFile file;
+	int _frame_idx;
+};
 
+/*
+Hog Detector:
+Runs OpenCV's people detector on the whole frame, or only on the search
+regions when they are set. The regions are merged into disjoint crops that are
+at least one detection window large; each crop is searched over the scales it
+can hold and the boxes are mapped back to frame coordinates.
+With HOG_THREAD_NUM>1 the CPU search runs on a thread pool: the pyramid levels
+are resized in parallel into buffers kept across frames, every level is cut
+into row tiles aligned to the window stride, and the hits are grouped in level
+and tile order, which gives the same boxes as detectMultiScale.
+*/
 class HogDetector:public Detector
 {
 public:
 	HogDetector();
 	virtual void detect(const Mat& frame, int gpu);
+	virtual bool needsFrame(){return true;}
+	virtual void setSearchRegions(const vector<Rect>& regions){_regions=regions;}
 
 private:
+	vector<Rect> getCrops(Size frame_size);//merged regions in the coordinates of the resized frame
+	void detectIn(const Mat& img, Point offset, int gpu);//append the detections in img, shifted by offset
+	void detectParallel(const Mat& img, vector<Rect>& found, vector<double>& weights);//weights of the hits before grouping
+
+	typedef struct HogTile
+	{
+		int level;
+		Rect roi;//rows of windows in the level image
+	}HogTile;
+
+	vector<Rect> _regions;
 	HOGDescriptor cpu_hog;
         gpu::HOGDescriptor gpu_hog;
 	vector<float> detector;
 	vector<float> repsonse;//classifier response
+
+	ThreadPool _pool;
+	vector<Mat> _level_buf;//memory of the pyramid levels, reused across frames
 };
 
+/*
+Async Detector:
+Runs a reader and a detector on a worker thread that stays up to queue_size
+frames ahead of the tracker, so that frame decoding and detection overlap with
+tracking. It is both the frame source and the detector of the main loop:
+readImg() pops the next frame and detect() returns the detections computed on
+it (after resizing by HOG_DETECT_FRAME_RATIO). With a fixed detection interval
+the worker skips the frames the tracker will not detect on. Search regions
+reach the detector with the lag of the queue. The wrapped reader and detector
+are not owned and must outlive this object.
+*/
+class AsyncDetector:public Detector, public SeqReader
+{
+public:
+	AsyncDetector(SeqReader* reader, Detector* detector, int queue_size, int gpu);
+	~AsyncDetector();
+	virtual void readImg(Mat& frame);
+	virtual void releaseImg(Mat& frame);
+	virtual void detect(const Mat& frame, int gpu);//the frame is ignored
+	virtual void setSearchRegions(const vector<Rect>& regions);//used from the next frame the worker reads
+
+private:
+	typedef struct DetectedFrame
+	{
+		Mat frame;
+		vector<Rect> detection;
+		vector<double> response;
+	}DetectedFrame;
+
+	void work();
+
+	SeqReader* _reader;
+	Detector* _detector;
+	int _gpu;
+	BoundedQueue<DetectedFrame> _queue;
+	DetectedFrame _current;
+	vector<Rect> _regions;
+	std::mutex _regions_mutex;
+	std::thread _worker;
+};
 
 #endif
@@ -0,0 +1,269 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include "frameSet.h"
+
+#define COUNT_SIZE (FEATURE_CHANNEL_NUM*BIN_SLOTS) // counts of one integral entry
+
+FrameSet::FrameSet():_tile_cols(0),_tile_rows(0),_tile_mutex_num(0),_hist_region_num(0)
+{
+	for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+	{
+		// same lookup as calcHist() builds for a uniform 8 bit histogram
+		float high= c==3 ? 179.0f : 255.0f;
+		double a=BIN_NUMBER/(double)high;
+		for (int v=0;v<256;v++)
+		{
+			int idx=cvFloor(v*a);
+			_bin_table[c][v]=(unsigned)idx<(unsigned)BIN_NUMBER ? (unsigned char)idx : BIN_OUT_OF_RANGE;
+		}
+	}
+}
+void FrameSet::setFrame(const Mat& frame)
+{
+	_bgr=frame;
+	_hsv.create(frame.size(),frame.type());
+	_lab.create(frame.size(),frame.type());
+	for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+		_bins[c].create(frame.size(),CV_8UC1);
+	_tile_cols=(frame.cols+FRAME_SET_TILE-1)/FRAME_SET_TILE;
+	_tile_rows=(frame.rows+FRAME_SET_TILE-1)/FRAME_SET_TILE;
+	_converted.assign(_tile_cols*_tile_rows,0);
+	if (_tile_mutex_num<_tile_cols*_tile_rows)
+	{
+		_tile_mutex_num=_tile_cols*_tile_rows;
+		_tile_mutex.reset(new std::mutex[_tile_mutex_num]);
+	}
+	_hist_region_num=0;
+}
+void FrameSet::getRoi(Rect roi, Mat* roi_set)
+{
+	convertTiles(roi);
+	roi_set[0]=Mat(_bgr,roi);
+	roi_set[1]=Mat(_hsv,roi);
+	roi_set[2]=Mat(_lab,roi);
+}
+void FrameSet::getBinRoi(Rect roi, Mat* roi_bins)
+{
+	convertTiles(roi);
+	for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+		roi_bins[c]=Mat(_bins[c],roi);
+}
+void FrameSet::quantize(const Mat& src, Mat* bins, const unsigned char (*table)[256])
+{
+	for (int y=0;y<src.rows;y++)
+	{
+		const unsigned char* s=src.ptr<unsigned char>(y);
+		unsigned char* b0=bins[0].ptr<unsigned char>(y);
+		unsigned char* b1=bins[1].ptr<unsigned char>(y);
+		unsigned char* b2=bins[2].ptr<unsigned char>(y);
+		for (int x=0;x<src.cols;x++,s+=3)
+		{
+			b0[x]=table[0][s[0]];
+			b1[x]=table[1][s[1]];
+			b2[x]=table[2][s[2]];
+		}
+	}
+}
+void FrameSet::convertTiles(Rect roi)
+{
+	roi&=Rect(0,0,_bgr.cols,_bgr.rows);
+	if (roi.area()==0)
+		return;
+
+	for (int ty=roi.y/FRAME_SET_TILE;ty<=(roi.y+roi.height-1)/FRAME_SET_TILE;ty++)
+	{
+		for (int tx=roi.x/FRAME_SET_TILE;tx<=(roi.x+roi.width-1)/FRAME_SET_TILE;tx++)
+		{
+			int t=ty*_tile_cols+tx;
+			std::lock_guard<std::mutex> lock(_tile_mutex[t]);
+			unsigned char& done=_converted[t];
+			if (done)
+				continue;
+			// the conversions are per pixel, so a tile gives the same values as the whole frame
+			Rect tile=Rect(tx*FRAME_SET_TILE,ty*FRAME_SET_TILE,FRAME_SET_TILE,FRAME_SET_TILE)
+				&Rect(0,0,_bgr.cols,_bgr.rows);
+			Mat src(_bgr,tile);
+			Mat hsv(_hsv,tile);
+			Mat lab(_lab,tile);
+			cvtColor(src,hsv,CV_RGB2HSV);
+			cvtColor(src,lab,CV_RGB2Lab);
+
+			Mat bins[FEATURE_CHANNEL_NUM];
+			for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+				bins[c]=Mat(_bins[c],tile);
+			quantize(src,bins,_bin_table);
+			quantize(hsv,bins+3,_bin_table+3);
+			quantize(lab,bins+6,_bin_table+6);
+			done=1;
+		}
+	}
+}
+void FrameSet::setHistogramRegions(const vector<Rect>& regions)
+{
+	Rect frame_win(0,0,_bgr.cols,_bgr.rows);
+	vector<Rect> merged;
+	for (size_t i=0;i<regions.size();i++)
+	{
+		Rect r=regions[i]&frame_win;
+		if (r.area()>0)
+			merged.push_back(r);
+	}
+	// merge until no two regions overlap
+	for (bool changed=true;changed;)
+	{
+		changed=false;
+		for (size_t i=0;i<merged.size() && !changed;i++)
+		{
+			for (size_t j=i+1;j<merged.size();j++)
+			{
+				if ((merged[i]&merged[j]).area()>0)
+				{
+					merged[i]|=merged[j];
+					merged.erase(merged.begin()+j);
+					changed=true;
+					break;
+				}
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_hist_regions.size()<merged.size())
+		_hist_regions.resize(merged.size());
+	for (size_t i=0;i<merged.size();i++)
+	{
+		_hist_regions[i].rect=merged[i];
+		_hist_regions[i].built=false;
+	}
+	_hist_region_num=(int)merged.size();
+}
+void FrameSet::countBins(Rect rect, int (*counts)[BIN_SLOTS])
+{
+	HistRegion* region=NULL;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (int i=0;i<_hist_region_num && region==NULL;i++)
+		{
+			if ((_hist_regions[i].rect&rect)==rect)
+				region=&_hist_regions[i];
+		}
+	}
+	if (region==NULL)
+	{
+		countPixels(rect,counts);
+		return;
+	}
+	if (!region->built)
+		buildIntegral(*region);
+
+	// the cells inside rect
+	Rect r=region->rect;
+	int cx0=(rect.x-r.x+HIST_CELL-1)/HIST_CELL;
+	int cy0=(rect.y-r.y+HIST_CELL-1)/HIST_CELL;
+	int cx1=MIN((rect.x+rect.width-r.x)/HIST_CELL,region->cells_x);
+	int cy1=MIN((rect.y+rect.height-r.y)/HIST_CELL,region->cells_y);
+	if (cx1<=cx0 || cy1<=cy0)
+	{
+		countPixels(rect,counts);
+		return;
+	}
+	int step=region->cells_x+1;
+	const int* i00=&region->integral[(cy0*step+cx0)*COUNT_SIZE];
+	const int* i01=&region->integral[(cy0*step+cx1)*COUNT_SIZE];
+	const int* i10=&region->integral[(cy1*step+cx0)*COUNT_SIZE];
+	const int* i11=&region->integral[(cy1*step+cx1)*COUNT_SIZE];
+	int* c=counts[0];
+	for (int k=0;k<COUNT_SIZE;k++)
+		c[k]+=i11[k]-i01[k]-i10[k]+i00[k];
+
+	// the strips around the cells
+	Rect inner(r.x+cx0*HIST_CELL,r.y+cy0*HIST_CELL,(cx1-cx0)*HIST_CELL,(cy1-cy0)*HIST_CELL);
+	countPixels(Rect(rect.x,rect.y,rect.width,inner.y-rect.y),counts);
+	countPixels(Rect(rect.x,inner.y+inner.height,rect.width,rect.y+rect.height-inner.y-inner.height),counts);
+	countPixels(Rect(rect.x,inner.y,inner.x-rect.x,inner.height),counts);
+	countPixels(Rect(inner.x+inner.width,inner.y,rect.x+rect.width-inner.x-inner.width,inner.height),counts);
+}
+void FrameSet::buildIntegral(HistRegion& region)
+{
+	convertTiles(region.rect);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (region.built)
+		return;
+	int cells_x=region.rect.width/HIST_CELL;
+	int cells_y=region.rect.height/HIST_CELL;
+	int step=cells_x+1;
+	region.cells_x=cells_x;
+	region.cells_y=cells_y;
+	region.integral.assign((cells_y+1)*step*COUNT_SIZE,0);
+
+	vector<int> row_sum(COUNT_SIZE);
+	vector<int> cell(COUNT_SIZE);
+	for (int cy=0;cy<cells_y;cy++)
+	{
+		std::fill(row_sum.begin(),row_sum.end(),0);
+		for (int cx=0;cx<cells_x;cx++)
+		{
+			std::fill(cell.begin(),cell.end(),0);
+			for (int y=0;y<HIST_CELL;y++)
+			{
+				int fy=region.rect.y+cy*HIST_CELL+y;
+				int fx=region.rect.x+cx*HIST_CELL;
+				for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+				{
+					const unsigned char* b=_bins[c].ptr<unsigned char>(fy)+fx;
+					int* h=&cell[c*BIN_SLOTS];
+					for (int x=0;x<HIST_CELL;x++)
+						h[b[x]]++;
+				}
+			}
+			const int* up=&region.integral[(cy*step+cx+1)*COUNT_SIZE];
+			int* dst=&region.integral[((cy+1)*step+cx+1)*COUNT_SIZE];
+			for (int k=0;k<COUNT_SIZE;k++)
+			{
+				row_sum[k]+=cell[k];
+				dst[k]=up[k]+row_sum[k];
+			}
+		}
+	}
+	region.built=true;
+}
+void FrameSet::countPixels(Rect rect, int (*counts)[BIN_SLOTS])
+{
+	if (rect.width<=0 || rect.height<=0)
+		return;
+	convertTiles(rect);
+	for (int c=0;c<FEATURE_CHANNEL_NUM;c++)
+	{
+		int* h=counts[c];
+		for (int y=rect.y;y<rect.y+rect.height;y++)
+		{
+			const unsigned char* b=_bins[c].ptr<unsigned char>(y)+rect.x;
+			for (int x=0;x<rect.width;x++)
+				h[b[x]]++;
+		}
+	}
+}
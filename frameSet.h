@@ -0,0 +1,109 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef FRAME_SET_H
+#define FRAME_SET_H
+
+#include <memory>
+#include <mutex>
+
+#include "opencv2/opencv.hpp"
+
+using namespace cv;
+using namespace std;
+
+#define FRAME_SET_TILE 64 // side of the tiles converted at a time
+
+#define BIN_NUMBER 32 // histogram bins per channel
+#define BIN_OUT_OF_RANGE BIN_NUMBER // bin index of values outside the histogram range
+#define BIN_SLOTS (BIN_NUMBER+1) // the bins and the out-of-range slot
+#define FEATURE_CHANNEL_NUM 9
+#define HIST_CELL 8 // cell side of the integral histograms
+
+/*
+Frame Set:
+The feature channels of a frame: BGR, HSV and Lab (9 channels). The frame is
+not copied, and the HSV and Lab planes are converted lazily, tile by tile, the
+first time a region is asked for; later requests in the same frame reuse the
+converted tiles. The planes are kept between frames to avoid reallocation.
+getRoi() may be called from several threads; each tile has its own lock, so
+threads only wait for each other on the tiles they both need.
+
+Together with the conversion, every channel is quantized into a plane of bin
+indices, the bins of the histograms of the appearance templates (BIN_NUMBER
+bins over [0,255], [0,179] for the hue). The quantization is the same as
+calcHist()/calcBackProject() with these ranges; values they leave out of the
+histogram (e.g. 255) get BIN_OUT_OF_RANGE.
+
+The bin counts of a rectangle (all channels) come from integral histograms
+over the regions given with setHistogramRegions(), the regions where the
+templates of the frame will be taken: each is built the first time it is
+needed, over cells of HIST_CELL pixels, and the strips of a rectangle off
+the cell grid are counted pixel by pixel. Other rectangles are counted pixel
+by pixel.
+*/
+class FrameSet
+{
+public:
+	FrameSet();
+	void setFrame(const Mat& frame);//the frame must not change while it is used
+	void getRoi(Rect roi, Mat* roi_set);//roi_set[0..2]: bgr, hsv and lab of roi (inside the frame)
+	void getBinRoi(Rect roi, Mat* roi_bins);//roi_bins[0..8]: bin indices of the 9 channels in roi
+	void setHistogramRegions(const vector<Rect>& regions);//overlapping regions are merged
+	void countBins(Rect rect, int (*counts)[BIN_SLOTS]);//adds the bin counts of rect (inside the frame) to counts[9]
+	inline int cols(){return _bgr.cols;}
+	inline int rows(){return _bgr.rows;}
+
+private:
+	typedef struct HistRegion
+	{
+		Rect rect;
+		bool built;
+		int cells_x;
+		int cells_y;
+		vector<int> integral;//(cells_y+1)*(cells_x+1) sets of counts
+	}HistRegion;
+
+	void convertTiles(Rect roi);
+	void quantize(const Mat& src, Mat* bins, const unsigned char (*table)[256]);
+	void buildIntegral(HistRegion& region);
+	void countPixels(Rect rect, int (*counts)[BIN_SLOTS]);
+
+	Mat _bgr;
+	Mat _hsv;
+	Mat _lab;
+	Mat _bins[FEATURE_CHANNEL_NUM];
+	unsigned char _bin_table[FEATURE_CHANNEL_NUM][256];//channel value -> bin index
+	vector<unsigned char> _converted;//one flag per tile, guarded by the tile's mutex
+	int _tile_cols;
+	int _tile_rows;
+	unique_ptr<std::mutex[]> _tile_mutex;
+	int _tile_mutex_num;
+	vector<HistRegion> _hist_regions;//kept between frames to reuse the buffers
+	int _hist_region_num;
+	std::mutex _mutex;//for the histogram regions
+};
+
+#endif
@@ -0,0 +1,207 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include <cstring>
+
+#include "kalmanFilter.h"
+
+static const int S=ConstVelocityKalman::STATE_NUM;
+
+/*
+Prediction of n filters whose elements are given as arrays over the filters
+(a single filter is n=1): with the transition F=[I I;0 I],
+	statePre=F*statePost
+	errorCovPre=F*errorCovPost*F'+processNoise
+where (F*P)(r,c)=P(r,c)+P(r+2,c) for r<2, and (A*F')(r,c)=A(r,c)+A(r,c+2) 
+for c<2.
+*/
+static void predictArrays(int n, const float* const* state, const float* const* cov, const float* const* noise,
+	float* const* state_pre, float* const* cov_pre)
+{
+	for (int k=0;k<2;k++)
+	{
+		const float* s=state[k];
+		const float* v=state[k+2];
+		float* p=state_pre[k];
+		float* pv=state_pre[k+2];
+		for (int i=0;i<n;i++)
+		{
+			p[i]=s[i]+v[i];
+			pv[i]=v[i];
+		}
+	}
+	for (int r=0;r<S;r++)
+	{
+		for (int c=0;c<S;c++)
+		{
+			float* out=cov_pre[r*S+c];
+			const float* q= r==c ? noise[r] : NULL;
+			// the four elements of P that make (F*P*F')(r,c)
+			const float* p00=cov[r*S+c];
+			const float* p10= r<2 ? cov[(r+2)*S+c] : NULL;
+			const float* p01= c<2 ? cov[r*S+c+2] : NULL;
+			const float* p11= r<2 && c<2 ? cov[(r+2)*S+c+2] : NULL;
+			for (int i=0;i<n;i++)
+			{
+				float a=p10 ? p00[i]+p10[i] : p00[i];//(F*P)(r,c)
+				if (p01)
+					a+=p11 ? p01[i]+p11[i] : p01[i];//(F*P)(r,c+2)
+				out[i]= q ? a+q[i] : a;
+			}
+		}
+	}
+}
+
+ConstVelocityKalman::ConstVelocityKalman()
+	:_measure_noise(1)
+{
+	memset(statePre,0,sizeof(statePre));
+	memset(statePost,0,sizeof(statePost));
+	memset(errorCovPre,0,sizeof(errorCovPre));
+	memset(errorCovPost,0,sizeof(errorCovPost));
+	for (int i=0;i<S;i++)
+		_process_noise[i]=1;
+}
+void ConstVelocityKalman::setErrorCov(float error_var)
+{
+	memset(errorCovPost,0,sizeof(errorCovPost));
+	for (int i=0;i<S;i++)
+		errorCovPost[i*S+i]=error_var;
+}
+void ConstVelocityKalman::setNoise(float pos_var, float vel_var, float measure_var)
+{
+	_process_noise[0]=_process_noise[1]=pos_var;
+	_process_noise[2]=_process_noise[3]=vel_var;
+	_measure_noise=measure_var;
+}
+void ConstVelocityKalman::predict()
+{
+	const float* state[S];
+	const float* noise[S];
+	float* state_pre[S];
+	const float* cov[S*S];
+	float* cov_pre[S*S];
+	for (int i=0;i<S;i++)
+	{
+		state[i]=&statePost[i];
+		noise[i]=&_process_noise[i];
+		state_pre[i]=&statePre[i];
+	}
+	for (int i=0;i<S*S;i++)
+	{
+		cov[i]=&errorCovPost[i];
+		cov_pre[i]=&errorCovPre[i];
+	}
+	predictArrays(1,state,cov,noise,state_pre,cov_pre);
+
+	// handle the case when there will be no measurement before the next predict
+	memcpy(statePost,statePre,sizeof(statePost));
+}
+void ConstVelocityKalman::correct(float x, float y)
+{
+	// innovation covariance H*P*H'+R, H=[I 0], and its inverse
+	double s00=errorCovPre[0]+(double)_measure_noise;
+	double s01=errorCovPre[1];
+	double s10=errorCovPre[S];
+	double s11=errorCovPre[S+1]+(double)_measure_noise;
+	double det=s00*s11-s01*s10;
+	if (det==0)
+		return;
+	double i00=s11/det, i01=-s01/det, i10=-s10/det, i11=s00/det;
+
+	// gain K=(S^-1*H*P)'
+	double gain[S][2];
+	for (int r=0;r<S;r++)
+	{
+		double hp0=errorCovPre[r];//(H*P)(0,r)
+		double hp1=errorCovPre[S+r];//(H*P)(1,r)
+		gain[r][0]=i00*hp0+i01*hp1;
+		gain[r][1]=i10*hp0+i11*hp1;
+	}
+
+	double dx=x-(double)statePre[0];
+	double dy=y-(double)statePre[1];
+	for (int r=0;r<S;r++)
+	{
+		statePost[r]=(float)(statePre[r]+gain[r][0]*dx+gain[r][1]*dy);
+		for (int c=0;c<S;c++)
+			errorCovPost[r*S+c]=(float)(errorCovPre[r*S+c]-gain[r][0]*errorCovPre[c]-gain[r][1]*errorCovPre[S+c]);
+	}
+}
+
+void KalmanBatch::resize(int n)
+{
+	_n=n;
+	for (int k=0;k<S;k++)
+	{
+		_state[k].resize(n);
+		_noise[k].resize(n);
+		_state_pre[k].resize(n);
+	}
+	for (int k=0;k<S*S;k++)
+	{
+		_cov[k].resize(n);
+		_cov_pre[k].resize(n);
+	}
+}
+void KalmanBatch::gather(int i, const ConstVelocityKalman& kf)
+{
+	for (int k=0;k<S;k++)
+	{
+		_state[k][i]=kf.statePost[k];
+		_noise[k][i]=kf._process_noise[k];
+	}
+	for (int k=0;k<S*S;k++)
+		_cov[k][i]=kf.errorCovPost[k];
+}
+void KalmanBatch::predict()
+{
+	if (_n==0)
+		return;
+	const float* state[S];
+	const float* noise[S];
+	float* state_pre[S];
+	const float* cov[S*S];
+	float* cov_pre[S*S];
+	for (int k=0;k<S;k++)
+	{
+		state[k]=&_state[k][0];
+		noise[k]=&_noise[k][0];
+		state_pre[k]=&_state_pre[k][0];
+	}
+	for (int k=0;k<S*S;k++)
+	{
+		cov[k]=&_cov[k][0];
+		cov_pre[k]=&_cov_pre[k][0];
+	}
+	predictArrays(_n,state,cov,noise,state_pre,cov_pre);
+}
+void KalmanBatch::scatter(int i, ConstVelocityKalman& kf)
+{
+	for (int k=0;k<S;k++)
+		kf.statePre[k]=kf.statePost[k]=_state_pre[k][i];
+	for (int k=0;k<S*S;k++)
+		kf.errorCovPre[k]=_cov_pre[k][i];
+}
@@ -0,0 +1,92 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef KALMAN_FILTER_H
+#define KALMAN_FILTER_H
+
+#include <vector>
+
+using namespace std;
+
+/*
+Constant Velocity Kalman Filter:
+The filter of the trackers: state (x, y, vx, vy), measurement (x, y), with
+diagonal noise covariances. It works like cv::KalmanFilter with the
+constant velocity transition and measurement matrices, on fixed-size arrays
+and without allocation; the 2x2 innovation covariance is inverted in closed
+form. As in cv::KalmanFilter (OpenCV 2.x), predict() also sets the post state
+to the prediction, so that a frame without correction goes on from it, but
+leaves the post covariance as it is. Covariances are 4x4 row-major arrays.
+*/
+class ConstVelocityKalman
+{
+public:
+	static const int STATE_NUM=4;
+	static const int MEASURE_NUM=2;
+
+	ConstVelocityKalman();
+	void setErrorCov(float error_var);//errorCovPost: identity*error_var
+	void setNoise(float pos_var, float vel_var, float measure_var);//process noise: diag(pos,pos,vel,vel), measurement noise: identity*measure_var
+	void predict();
+	void correct(float x, float y);
+
+	float statePre[STATE_NUM];
+	float statePost[STATE_NUM];
+	float errorCovPre[STATE_NUM*STATE_NUM];
+	float errorCovPost[STATE_NUM*STATE_NUM];
+
+private:
+	friend class KalmanBatch;
+	float _process_noise[STATE_NUM];//diagonal
+	float _measure_noise;
+};
+
+/*
+Kalman Batch:
+The prediction of many filters in one pass. The filters are copied in with
+gather(), predicted together in structure-of-arrays layout, where each
+element of the state and covariance is a contiguous array over the filters
+so the loops vectorize, and copied back with scatter(). The result is the
+same as ConstVelocityKalman::predict() on each filter.
+*/
+class KalmanBatch
+{
+public:
+	KalmanBatch():_n(0){}
+	void resize(int n);
+	void gather(int i, const ConstVelocityKalman& kf);
+	void predict();
+	void scatter(int i, ConstVelocityKalman& kf);
+
+private:
+	int _n;
+	vector<float> _state[ConstVelocityKalman::STATE_NUM];
+	vector<float> _cov[ConstVelocityKalman::STATE_NUM*ConstVelocityKalman::STATE_NUM];
+	vector<float> _noise[ConstVelocityKalman::STATE_NUM];
+	vector<float> _state_pre[ConstVelocityKalman::STATE_NUM];
+	vector<float> _cov_pre[ConstVelocityKalman::STATE_NUM*ConstVelocityKalman::STATE_NUM];
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include <cfloat>
+#include <algorithm>
+
+#include "lapjv.h"
+
+void LapJV::solve(Matrix<double>& m)
+{
+	int rows=m.rows();
+	int cols=m.columns();
+	if (rows==0 || cols==0)
+		return;
+
+	// forbidden pairs cost more than any allowed one
+	double high_value=0;
+	const double* src=m.data();
+	for (int k=0;k<rows*cols;k++)
+		if (src[k]!=ASSIGNMENT_INFINITY && src[k]>high_value)
+			high_value=src[k];
+	high_value++;
+
+	// each row of the problem gets a column, so the problem is the transpose when there are more rows
+	bool transposed= rows>cols;
+	_rows= transposed ? cols : rows;
+	_cols= transposed ? rows : cols;
+	_cost.resize(_rows*_cols);
+	for (int r=0;r<rows;r++)
+	{
+		for (int c=0;c<cols;c++)
+		{
+			double v=src[r*cols+c];
+			_cost[transposed ? c*_cols+r : r*_cols+c]= v==ASSIGNMENT_INFINITY ? high_value : v;
+		}
+	}
+
+	_u.assign(_rows,0);
+	_v.assign(_cols,0);
+	_col4row.assign(_rows,-1);
+	_row4col.assign(_cols,-1);
+	_shortest.resize(_cols);
+	_path.resize(_cols);
+	_remaining.resize(_cols);
+	_row_visited.resize(_rows);
+	_col_visited.resize(_cols);
+	for (int r=0;r<_rows;r++)
+		augment(r);
+
+	// assignments are 0, the rest -1
+	double* dst=m.data();
+	std::fill(dst,dst+rows*cols,-1.0);
+	for (int r=0;r<_rows;r++)
+	{
+		int c=_col4row[r];
+		if (transposed)
+			dst[c*cols+r]=0;
+		else
+			dst[r*cols+c]=0;
+	}
+}
+/*
+Assigns cur_row by the shortest path of reduced costs from it to a free
+column, alternating through assigned columns and their rows (Dijkstra over
+the columns), then updates the dual variables so that the reduced costs stay
+non-negative, and flips the assignments along the path.
+*/
+void LapJV::augment(int cur_row)
+{
+	std::fill(_shortest.begin(),_shortest.end(),DBL_MAX);
+	std::fill(_path.begin(),_path.end(),-1);
+	std::fill(_row_visited.begin(),_row_visited.end(),false);
+	std::fill(_col_visited.begin(),_col_visited.end(),false);
+	int remaining_num=_cols;
+	for (int k=0;k<_cols;k++)
+		_remaining[k]=_cols-k-1;
+
+	double min_val=0;
+	int i=cur_row;
+	int sink=-1;
+	while (sink==-1)
+	{
+		_row_visited[i]=true;
+		const double* cost_row=&_cost[i*_cols];
+		int index=-1;
+		double lowest=DBL_MAX;
+		for (int k=0;k<remaining_num;k++)
+		{
+			int j=_remaining[k];
+			double r=min_val+cost_row[j]-_u[i]-_v[j];
+			if (r<_shortest[j])
+			{
+				_path[j]=i;
+				_shortest[j]=r;
+			}
+			// a free column ends the path, so it wins the ties
+			if (_shortest[j]<lowest || (_shortest[j]==lowest && _row4col[j]==-1))
+			{
+				lowest=_shortest[j];
+				index=k;
+			}
+		}
+
+		min_val=lowest;
+		int j=_remaining[index];
+		if (_row4col[j]==-1)
+			sink=j;
+		else
+			i=_row4col[j];
+		_col_visited[j]=true;
+		_remaining[index]=_remaining[--remaining_num];
+	}
+
+	// update the dual variables
+	_u[cur_row]+=min_val;
+	for (int r=0;r<_rows;r++)
+		if (_row_visited[r] && r!=cur_row)
+			_u[r]+=min_val-_shortest[_col4row[r]];
+	for (int c=0;c<_cols;c++)
+		if (_col_visited[c])
+			_v[c]-=min_val-_shortest[c];
+
+	// flip the assignments along the path
+	int j=sink;
+	while (true)
+	{
+		int r=_path[j];
+		_row4col[j]=r;
+		std::swap(_col4row[r],j);
+		if (r==cur_row)
+			break;
+	}
+}
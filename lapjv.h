@@ -0,0 +1,67 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef LAPJV_H
+#define LAPJV_H
+
+#include <vector>
+
+#include "matrix.h"
+
+using namespace std;
+
+#define ASSIGNMENT_INFINITY 1000000000 // a pair that must not be assigned, the same value as Munkres' INFINITY
+
+/*
+LapJV:
+Solves the rectangular linear assignment problem like Munkres::solve(): the
+entries equal to ASSIGNMENT_INFINITY are first replaced by one more than the
+largest other entry, then min(rows, columns) pairs of least total cost are
+assigned and the matrix is overwritten with 0 for them and -1 elsewhere.
+It uses the shortest augmenting paths of Jonker and Volgenant with dual
+variables, one path per row (per column when there are more rows), which is
+O(n^2*m) on a contiguous copy of the costs instead of the O(n^4) rescans of
+Munkres. When several assignments have the least cost, the two solvers may
+pick different ones.
+*/
+class LapJV
+{
+public:
+	void solve(Matrix<double>& m);
+
+private:
+	void augment(int cur_row);
+
+	int _rows, _cols;//of the problem, _rows<=_cols
+	vector<double> _cost;//row-major
+	vector<double> _u, _v;//dual variables of the rows and the columns
+	vector<int> _col4row, _row4col;
+	vector<double> _shortest;
+	vector<int> _path;
+	vector<int> _remaining;
+	vector<bool> _row_visited, _col_visited;
+};
+
+#endif
@@ -26,17 +26,20 @@
 USAGE:
 
 	a.
-	Hierarchy_Ensemble <path_of_sequence> <is_image> 
+	Hierarchy_Ensemble <path_of_sequence> <is_image> <gpu>
 	b.
-	Hierarchy_Ensemble <path_of_sequence> <is_image> <path_detection_file>
+	Hierarchy_Ensemble <path_of_sequence> <is_image> <gpu> <path_detection_file>
 
 	<path_of_seuqence>: the path of the directory containing images or the path of the video
 	<is_image>: '1' for image format sequence, '0' the video format sequence
-	<path_detection_file>: the xml detection file, whose structure should follow the example in 
-	the supplementary files
+	<gpu>: '1' to run the HOG detector on the GPU, '0' on the CPU
+	<path_detection_file>: the detection file. A '.xml' file should follow the structure of the 
+	example in the supplementary files; a '.bin' file is a binary detection file made by 
+	'detConvert' (see binDetection.h); any other file is read as text with one box per line:
+	"<frame> <x1> <y1> <x2> <y2> [confidence]" (e.g. darknet's det.txt)
 
 	When <detection_file> is not specified, the program will use the HOG detector to detect 
-	pedestrians online; Otherwise, the xml file specified will be read to get the detection results in
+	pedestrians online; Otherwise, the file specified will be read to get the detection results in
 	it. For the exact structure of the detection file, see the example files in the supplementary files.
 
 	You may need to change the parameters stored in 'config.txt'. There are detailed explanations and 
@@ -46,18 +49,19 @@ USAGE:
 EXAMPLE:
 
 	a.
-	Hierarchy_Ensemble C:/video_data/TownCentreXVID.avi 0
+	Hierarchy_Ensemble C:/video_data/TownCentreXVID.avi 0 0
 	(The program will use the OpenCV's HOG detector)
 	b.
-	Hierarchy_Ensemble C:/video_data/PETS09S2L1/ 1 C:/PETS09_S2L1_det_opencv.xml
+	Hierarchy_Ensemble C:/video_data/PETS09S2L1/ 1 0 C:/PETS09_S2L1_det_opencv.xml
 	(The program will read the images stored in the directory and use the detection xml file as the 
 	source of detections)
 
 
 NOTE:
 
-	(*) When the program is running, type 'p' to pause and 'q' to quit.
+	(*) When the program is running, type 'p' to pause and 'q' to quit (not in HEADLESS mode, see 'config.txt').
 	(**) The tracking result will be recorded in a file named "output.xml".
+	(***) With TRACK_LOG (see 'config.txt'), the trajectories of all trackers are written to "tracks.bin" (see trackLog.h).
 */
 
 #include <ctime>
@@ -69,6 +73,7 @@ NOTE:
 #include "detector.h"
 #include "dataReader.h"
 #include "multiTrackAssociation.h"
+#include "renderer.h"
 #include "parameter.h"
 
 extern "C" {
@@ -81,7 +86,7 @@ using namespace cv;
 using namespace std;
 
 static string _sequence_path_;
-static string _detection_xml_file_;
+static string _detection_file_;
 
 //Configuration
 int MAX_TRACKER_NUM;
@@ -92,6 +97,18 @@ double TRACKING_TO_BODYSIZE_RATIO;
 int FRAME_RATE;
 double TIME_WINDOW_SIZE;
 double HOG_DETECT_FRAME_RATIO;
+int HOG_THREAD_NUM;
+int TRACKER_THREAD_NUM;
+int PREFETCH_FRAME_NUM;
+int DECODE_THREAD_NUM=1;
+int DETECTION_QUEUE_SIZE;
+int HEADLESS;
+int RENDER_OUTPUT=1;
+int TRACK_LOG=0;
+int DETECTION_INTERVAL=1;
+int ADAPTIVE_DETECTION_INTERVAL;
+int ROI_DETECTION;
+int FULL_SWEEP_INTERVAL=1;
 
 void read_config()
 {
@@ -118,6 +135,10 @@ void read_config()
 			line_s>>TIME_WINDOW_SIZE;
 		else if (field.compare("HOG_DETECT_FRAME_RATIO:")==0)
 			line_s>>HOG_DETECT_FRAME_RATIO;
+		else if (field.compare("HOG_THREAD_NUM:")==0)
+			line_s>>HOG_THREAD_NUM;
+		else if (field.compare("TRACKER_THREAD_NUM:")==0)
+			line_s>>TRACKER_THREAD_NUM;
 		else if (field.compare("MAX_TEMPLATE_SIZE:")==0)
 			line_s>>MAX_TEMPLATE_SIZE;
 		else if (field.compare("EXPERT_THRESH:")==0)
@@ -126,6 +147,26 @@ void read_config()
 			line_s>>BODYSIZE_TO_DETECTION_RATIO;
 		else if (field.compare("TRACKING_TO_BODYSIZE_RATIO:")==0)
 			line_s>>TRACKING_TO_BODYSIZE_RATIO;
+		else if (field.compare("HEADLESS:")==0)
+			line_s>>HEADLESS;
+		else if (field.compare("RENDER_OUTPUT:")==0)
+			line_s>>RENDER_OUTPUT;
+		else if (field.compare("TRACK_LOG:")==0)
+			line_s>>TRACK_LOG;
+		else if (field.compare("PREFETCH_FRAME_NUM:")==0)
+			line_s>>PREFETCH_FRAME_NUM;
+		else if (field.compare("DECODE_THREAD_NUM:")==0)
+			line_s>>DECODE_THREAD_NUM;
+		else if (field.compare("DETECTION_QUEUE_SIZE:")==0)
+			line_s>>DETECTION_QUEUE_SIZE;
+		else if (field.compare("DETECTION_INTERVAL:")==0)
+			line_s>>DETECTION_INTERVAL;
+		else if (field.compare("ADAPTIVE_DETECTION_INTERVAL:")==0)
+			line_s>>ADAPTIVE_DETECTION_INTERVAL;
+		else if (field.compare("ROI_DETECTION:")==0)
+			line_s>>ROI_DETECTION;
+		else if (field.compare("FULL_SWEEP_INTERVAL:")==0)
+			line_s>>FULL_SWEEP_INTERVAL;
 	}
 	conf_file.close();
 }
@@ -147,13 +188,6 @@ void multiTrack(int readerType,int detectorType, int gpu)
 			cerr<<"no such reader type!"<<endl;
 			return ;
 	}
-	reader->readImg(frame);
-	if (frame.data==NULL)
-	{
-		cerr<<"fail to open pictures!"<<endl;
-		return ;
-	}
-
 	Detector* detector;
 	switch (detectorType)
 	{
@@ -161,42 +195,90 @@ void multiTrack(int readerType,int detectorType, int gpu)
             detector=new HogDetector();
             break;
         case XML:
-            detector=new XMLDetector(_detection_xml_file_.c_str());
+            detector=new XMLDetector(_detection_file_.c_str());
+            break;
+        case TXT:
+            detector=new DetectionSource(_detection_file_.c_str());
+            break;
+        case BIN:
+            detector=new BinDetector(_detection_file_.c_str());
             break;
         default:
             detector=new HogDetector();
             break;
 	}
 
-	TrakerManager mTrack(detector,frame,EXPERT_THRESH);
-	VideoWriter v("output.avi", CV_FOURCC('X','V','I','D'), 9, Size(1280,720), true);
+	// decode frames ahead on background threads
+	PrefetchReader* prefetch=NULL;
+	SeqReader* source=reader;
+	if (PREFETCH_FRAME_NUM>0)
+	{
+		prefetch=new PrefetchReader(reader,PREFETCH_FRAME_NUM,DECODE_THREAD_NUM);
+		source=prefetch;
+	}
+
+	// run reading and detection ahead of the tracker on a worker thread
+	AsyncDetector* pipeline=NULL;
+	Detector* source_detector=detector;
+	if (DETECTION_QUEUE_SIZE>0)
+	{
+		pipeline=new AsyncDetector(source,detector,DETECTION_QUEUE_SIZE,gpu);
+		source=pipeline;
+		source_detector=pipeline;
+	}
+
+	source->readImg(frame);
+	if (frame.data==NULL)
+	{
+		cerr<<"fail to open pictures!"<<endl;
+		delete pipeline;
+		delete prefetch;
+		delete reader;
+		delete detector;
+		return ;
+	}
+
+	TrakerManager mTrack(source_detector,frame,EXPERT_THRESH);
+
+	// the window needs the annotated frame at once, only a headless run can render in the background
+	Renderer* renderer=NULL;
+	if (!HEADLESS || RENDER_OUTPUT>0)
+		renderer=new Renderer(HEADLESS && RENDER_OUTPUT==2,RENDER_OUTPUT>0);
 	for (int frameCount=0;frame.data!=NULL;frameCount++)
 	{
         clock_t begin = clock();
 		mTrack.doWork(frame, gpu, frameCount);
-        if (frame.cols > 1920 || frame.rows > 1080) {
-            cv::pyrDown(frame, frame, cv::Size(frame.cols / 2, frame.rows / 2));
-        }
-        moveWindow("PedCount", 0, 0);
-        imshow("PedCount", frame);
-		v.write(frame);
-		reader->readImg(frame);
-
-		char c = waitKey(1);
-		if(c == 'q') break;
-		else if (c=='p')
-		{
-			cvWaitKey(0);
-		}
-		else if(c != -1)
+		Mat annotated;
+		if (renderer!=NULL)
+			annotated=renderer->render(mTrack.getSnapshot());
+
+		if (!HEADLESS)
 		{
-			mTrack.setKey(c);
+			moveWindow("PedCount", 0, 0);
+			imshow("PedCount", annotated);
+			char c = waitKey(1);
+			if(c == 'q') break;
+			else if (c=='p')
+			{
+				cvWaitKey(0);
+			}
+			else if(c != -1)
+			{
+				mTrack.setKey(c);
+			}
 		}
+
+		// the annotated frame may share the buffer of the input frame, so release it after display
+		source->releaseImg(frame);
+		source->readImg(frame);
         clock_t end = clock();
         double elapsed_time = (end - begin) / (CLOCKS_PER_SEC/1000);
         //cout << elapsed_time << endl;
 	}
 
+	delete renderer;
+	delete pipeline;
+	delete prefetch;
 	delete reader;
 	delete detector;
 }
@@ -205,15 +287,16 @@ void help()
 {
 	cout<<"usage: \n\n"
 		"1.\n" 
-		"Hierarchy_Ensemble <sequence_path> <is_image>\n"
+		"Hierarchy_Ensemble <sequence_path> <is_image> <gpu>\n"
 		"(by default, it uses hog detector in opencv to detect pedestrians)\n\n"
 
 		"2.\n"
-		"Hierarchy_Ensemble <sequence_path> <is_image> <detection_xml_file_path>\n"
-		"(it uses detection stored in the specified xml file. You may rescale the detection bounding box "
+		"Hierarchy_Ensemble <sequence_path> <is_image> <gpu> <detection_file_path>\n"
+		"(it uses detection stored in the specified xml or text file. You may rescale the detection bounding box "
 		"by tuning parameters in the \"he_config.txt\")\n\n"
 
-		"<is_image>: \'1\' for image format data. \'0\' for video format data.\n";
+		"<is_image>: \'1\' for image format data. \'0\' for video format data.\n"
+		"<gpu>: \'1\' to run the hog detector on gpu. \'0\' on cpu.\n";
 	getchar();
 }
 
@@ -247,8 +330,15 @@ int main(int argc,char** argv)
 	
 	if (argc>4)
 	{
-		_detection_xml_file_=string(argv[4]);
-		multiTrack(seq_format,XML, gpu);
+		_detection_file_=string(argv[4]);
+		size_t dot=_detection_file_.rfind('.');
+		string ext= dot==string::npos ? "" : _detection_file_.substr(dot);
+		if (ext==".xml")
+			multiTrack(seq_format,XML, gpu);
+		else if (ext==".bin")
+			multiTrack(seq_format,BIN, gpu);
+		else
+			multiTrack(seq_format,TXT, gpu);
 	}
 	else
 		multiTrack(seq_format,HOG, gpu);
@@ -19,6 +19,11 @@
 #if !defined(_MATRIX_H_)
 #define _MATRIX_H_
 
+#include <cassert>
+#include <cstdlib>
+#include <algorithm>
+
+// rows x columns elements, stored row by row in one block
 template <class T>
 class Matrix {
 public:
@@ -31,7 +36,14 @@ public:
 	void resize(int rows, int columns);
 	void identity(void);
 	void clear(void);
-	T& operator () (int x, int y);
+	inline T& operator () (int x, int y) {
+		assert ( x >= 0 );
+		assert ( y >= 0 );
+		assert ( x < m_rows );
+		assert ( y < m_columns );
+		assert ( m_matrix != NULL );
+		return m_matrix[x*m_columns+y];
+	}
 	T trace(void);
 	Matrix<T>& transpose(void);
 	Matrix<T> product(Matrix<T> &other);
@@ -44,19 +56,16 @@ public:
 	int rows(void) {
 		return m_rows;
 	}
+	T* data(void) {// row-major, rows()*columns() elements
+		return m_matrix;
+	}
 private:
-	T **m_matrix;
+	T *m_matrix;
 	int m_rows;
 	int m_columns;
 };
 
 
-#include "matrix.h"
-
-#include <cassert>
-#include <cstdlib>
-#include <algorithm>
-
 /*export*/ template <class T>
 Matrix<T>::Matrix() {
 	m_rows = 0;
@@ -66,40 +75,40 @@ Matrix<T>::Matrix() {
 
 /*export*/ template <class T>
 Matrix<T>::Matrix(const Matrix<T> &other) {
+	m_matrix = NULL;
+	m_rows = 0;
+	m_columns = 0;
 	if ( other.m_matrix != NULL ) {
-		// copy arrays
-		m_matrix = NULL;
+		// copy array
 		resize(other.m_rows, other.m_columns);
-		for ( int i = 0 ; i < m_rows ; i++ )
-			for ( int j = 0 ; j < m_columns ; j++ )
-				m_matrix[i][j] = other.m_matrix[i][j];
-	} else {
-		m_matrix = NULL;
-		m_rows = 0;
-		m_columns = 0;
+		std::copy(other.m_matrix, other.m_matrix + m_rows * m_columns, m_matrix);
 	}
 }
 
 /*export*/ template <class T>
 Matrix<T>::Matrix(int rows, int columns) {
 	m_matrix = NULL;
+	m_rows = 0;
+	m_columns = 0;
 	resize(rows, columns);
 }
 
 /*export*/ template <class T>
 Matrix<T> &
 	Matrix<T>::operator= (const Matrix<T> &other) {
+		if ( this == &other )
+			return *this;
 		if ( other.m_matrix != NULL ) {
-			// copy arrays
-			resize(other.m_rows, other.m_columns);
-			for ( int i = 0 ; i < m_rows ; i++ )
-				for ( int j = 0 ; j < m_columns ; j++ )
-					m_matrix[i][j] = other.m_matrix[i][j];
+			// copy array, the block is reused when the size is the same
+			if ( m_rows * m_columns != other.m_rows * other.m_columns ) {
+				delete [] m_matrix;
+				m_matrix = new T[other.m_rows * other.m_columns];
+			}
+			m_rows = other.m_rows;
+			m_columns = other.m_columns;
+			std::copy(other.m_matrix, other.m_matrix + m_rows * m_columns, m_matrix);
 		} else {
-			// free arrays
-			for ( int i = 0 ; i < m_columns ; i++ )
-				delete [] m_matrix[i];
-
+			// free array
 			delete [] m_matrix;
 
 			m_matrix = NULL;
@@ -112,57 +121,31 @@ Matrix<T> &
 
 /*export*/ template <class T>
 Matrix<T>::~Matrix() {
-	if ( m_matrix != NULL ) {
-		// free arrays
-		for ( int i = 0 ; i < m_rows ; i++ )
-			delete [] m_matrix[i];
-
-		delete [] m_matrix;
-	}
+	delete [] m_matrix;
 	m_matrix = NULL;
 }
 
 /*export*/ template <class T>
 void
 	Matrix<T>::resize(int rows, int columns) {
-		if ( m_matrix == NULL ) {
-			// alloc arrays
-			m_matrix = new T*[rows]; // rows
-			for ( int i = 0 ; i < rows ; i++ )
-				m_matrix[i] = new T[columns]; // columns
-
-			m_rows = rows;
-			m_columns = columns;
-			clear();
-		} else {
-			// save array pointer
-			T **new_matrix;
-			// alloc new arrays
-			new_matrix = new T*[rows]; // rows
-			for ( int i = 0 ; i < rows ; i++ ) {
-				new_matrix[i] = new T[columns]; // columns
-				for ( int j = 0 ; j < columns ; j++ )
-					new_matrix[i][j] = 0;
-			}
+		if ( m_matrix != NULL && rows == m_rows && columns == m_columns )
+			return;
 
-			// copy data from saved pointer to new arrays
+		// alloc new array
+		T *new_matrix = new T[rows * columns];
+		std::fill(new_matrix, new_matrix + rows * columns, T(0));
+
+		// copy data from the old array
+		if ( m_matrix != NULL ) {
 			int minrows = std::min<int>(rows, m_rows);
 			int mincols = std::min<int>(columns, m_columns);
 			for ( int x = 0 ; x < minrows ; x++ )
-				for ( int y = 0 ; y < mincols ; y++ )
-					new_matrix[x][y] = m_matrix[x][y];
-
-			// delete old arrays
-			if ( m_matrix != NULL ) {
-				for ( int i = 0 ; i < m_rows ; i++ )
-					delete [] m_matrix[i];
-
-				delete [] m_matrix;
-			}
+				std::copy(m_matrix + x * m_columns, m_matrix + x * m_columns + mincols, new_matrix + x * columns);
 
-			m_matrix = new_matrix;
+			delete [] m_matrix;
 		}
 
+		m_matrix = new_matrix;
 		m_rows = rows;
 		m_columns = columns;
 }
@@ -176,7 +159,7 @@ void
 
 		int x = std::min<int>(m_rows, m_columns);
 		for ( int i = 0 ; i < x ; i++ )
-			m_matrix[i][i] = 1;
+			(*this)(i,i) = 1;
 }
 
 /*export*/ template <class T>
@@ -184,9 +167,7 @@ void
 	Matrix<T>::clear() {
 		assert( m_matrix != NULL );
 
-		for ( int i = 0 ; i < m_rows ; i++ )
-			for ( int j = 0 ; j < m_columns ; j++ )
-				m_matrix[i][j] = 0;
+		std::fill(m_matrix, m_matrix + m_rows * m_columns, T(0));
 }
 
 /*export*/ template <class T>
@@ -198,7 +179,7 @@ T
 
 		int x = std::min<int>(m_rows, m_columns);
 		for ( int i = 0 ; i < x ; i++ )
-			value += m_matrix[i][i];
+			value += (*this)(i,i);
 
 		return value;
 }
@@ -209,27 +190,14 @@ Matrix<T>&
 		assert( m_rows > 0 );
 		assert( m_columns > 0 );
 
-		int new_rows = m_columns;
-		int new_columns = m_rows;
-
-		if ( m_rows != m_columns ) {
-			// expand matrix
-			int m = std::max<int>(m_rows, m_columns);
-			resize(m,m);
-		}
-
-		for ( int i = 0 ; i < m_rows ; i++ ) {
-			for ( int j = i+1 ; j < m_columns ; j++ ) {
-				T tmp = m_matrix[i][j];
-				m_matrix[i][j] = m_matrix[j][i];
-				m_matrix[j][i] = tmp;
-			}
-		}
+		Matrix<T> out(m_columns, m_rows);
+		for ( int i = 0 ; i < m_rows ; i++ )
+			for ( int j = 0 ; j < m_columns ; j++ )
+				out(j,i) = (*this)(i,j);
 
-		if ( new_columns != new_rows ) {
-			// trim off excess.
-			resize(new_rows, new_columns);
-		}
+		std::swap(m_matrix, out.m_matrix);
+		std::swap(m_rows, out.m_rows);
+		std::swap(m_columns, out.m_columns);
 
 		return *this;
 }
@@ -243,10 +211,12 @@ Matrix<T>
 
 		Matrix<T> out(m_rows, other.m_columns);
 
+		// i, x, j order walks both operands along their rows
 		for ( int i = 0 ; i < out.m_rows ; i++ ) {
-			for ( int j = 0 ; j < out.m_columns ; j++ ) {
-				for ( int x = 0 ; x < m_columns ; x++ ) {
-					out(i,j) += m_matrix[i][x] * other.m_matrix[x][j];
+			for ( int x = 0 ; x < m_columns ; x++ ) {
+				T a = (*this)(i,x);
+				for ( int j = 0 ; j < out.m_columns ; j++ ) {
+					out(i,j) += a * other(x,j);
 				}
 			}
 		}
@@ -254,21 +224,4 @@ Matrix<T>
 		return out;
 }
 
-/*export*/ template <class T>
-T&
-	Matrix<T>::operator ()(int x, int y) {
-		assert ( x >= 0 );
-		assert ( y >= 0 );
-		assert ( x < m_rows );
-		assert ( y < m_columns );
-		assert ( m_matrix != NULL );
-		return m_matrix[x][y];
-}
-
-//#ifndef USE_EXPORT_KEYWORD
-//#include "matrix.cpp"
-//#define export /*export*/
-//#endif
-
 #endif /* !defined(_MATRIX_H_) */
-
@@ -28,7 +28,7 @@
 #include <fstream>
 
 #include "parameter.h"
-#include "munkres.h"
+#include "lapjv.h"
 #include "multiTrackAssociation.h"
 #include "util.h"
 
@@ -38,39 +38,36 @@ using namespace std;
 
 void WaitingList::update()
 {
-    for (list<Waiting>::iterator it=w_list.begin();it!=w_list.end();)
+    size_t kept=0;
+    for (size_t k=0;k<w_list.size();k++)
     {
-        if ((*it).life_count>life_limit)
-        {
-            w_list.erase(it++);
+        if (w_list[k].life_count>life_limit)
             continue;
-        }
-        else
-        {
-            (*it).life_count++;
-        }
-        it++;
+        w_list[k].life_count++;
+        w_list[kept++]=w_list[k];
     }
+    w_list.erase(w_list.begin()+kept,w_list.end());
 }
 vector<Rect>WaitingList::outputQualified(double thresh)
 {
     vector<Rect> ret;
-    for (list<Waiting>::iterator it=w_list.begin();it!=w_list.end();)
+    size_t kept=0;
+    for (size_t k=0;k<w_list.size();k++)
     {
-        if ((*it).accu>thresh)
+        if (w_list[k].accu>thresh)
         {
-            ret.push_back((*it).currentWin);
-            w_list.erase(it++);
+            ret.push_back(w_list[k].currentWin);
             continue;
         }
-        it++;
+        w_list[kept++]=w_list[k];
     }
+    w_list.erase(w_list.begin()+kept,w_list.end());
     return ret;
 }
 void WaitingList::feed(Rect gt_win,double response)
 {
     Point center((int)(gt_win.x+0.5*gt_win.width),(int)(gt_win.y+0.5*gt_win.height));
-    for (list<Waiting>::iterator it=w_list.begin();it!=w_list.end();it++)
+    for (vector<Waiting>::iterator it=w_list.begin();it!=w_list.end();it++)
     {
         double x1=center.x;
         double y1=center.y;
@@ -89,6 +86,13 @@ void WaitingList::feed(Rect gt_win,double response)
     }
     w_list.push_back(Waiting(gt_win));
 }
+vector<Rect> WaitingList::getWindows()
+{
+    vector<Rect> ret;
+    for (vector<Waiting>::iterator it=w_list.begin();it!=w_list.end();it++)
+        ret.push_back((*it).currentWin);
+    return ret;
+}
 /************************************************************************/
 Controller::Controller(Size sz,int r, int c,double vh,double lr,double thresh_expert)
         :_hit_record(),
@@ -177,11 +181,11 @@ vector<int> Controller::filterDetection(vector<Rect> detction_bodysize)
     }
     return ret;
 }
-void Controller::takeVoteForAvgHittingRate(list<EnsembleTracker*> _tracker_list)
+void Controller::takeVoteForAvgHittingRate(vector<TrackerHandle>& _tracker_list)
 {
     double vote_count=0;
     vector<double> hitting;
-    for (list<EnsembleTracker*>::iterator it=_tracker_list.begin();it!=_tracker_list.end();it++)
+    for (vector<TrackerHandle>::iterator it=_tracker_list.begin();it!=_tracker_list.end();it++)
     {
         Rect win=(*it)->getBodysizeResult();
         // only moving objects vote
@@ -189,34 +193,35 @@ void Controller::takeVoteForAvgHittingRate(list<EnsembleTracker*> _tracker_list)
             _hit_record.recordVote((*it)->getAddNew());
     }
 }
-void Controller::deleteObsoleteTracker(list<EnsembleTracker*>& _tracker_list)
+void Controller::deleteObsoleteTracker(vector<TrackerHandle>& _tracker_list)
 {
     /*
     Tracker death control. For modifying termination conditions, change here.
     */
     waitList_suspicious.update();
     double l=_hit_record._getAvgHittingRate(_alpha_hitting_rate,_beta_hitting_rate);
-    for (list<EnsembleTracker*>::iterator it=_tracker_list.begin();it!=_tracker_list.end();)
+    size_t kept=0;
+    for (size_t k=0;k<_tracker_list.size();k++)
     {
-        if((*it)->getHitFreq()*TIME_WINDOW_SIZE<=MAX(l-2*sqrt(l),0))
+        TrackerHandle tracker=_tracker_list[k];
+        if(tracker->getHitFreq()*TIME_WINDOW_SIZE<=MAX(l-2*sqrt(l),0))
         {
-            (*it)->refcDec1();
-            (*it)->dump();
-            _tracker_list.erase(it++);
+            EnsembleTracker::destroy(tracker);
             continue;
         }
-        else if (!(*it)->getIsNovice() && (*it)->getTemplateNum()<_thresh_for_expert)
+        else if (!tracker->getIsNovice() && tracker->getTemplateNum()<_thresh_for_expert)
         {
-            (*it)->demote();
+            tracker->demote();
         }
-        it++;
+        _tracker_list[kept++]=tracker;
     }
+    _tracker_list.erase(_tracker_list.begin()+kept,_tracker_list.end());
 }
-void Controller::calcSuspiciousArea(list<EnsembleTracker*>& _tracker_list)
+void Controller::calcSuspiciousArea(vector<TrackerHandle>& _tracker_list)
 {
     double l=_hit_record._getAvgHittingRate(_alpha_hitting_rate,_beta_hitting_rate);
     waitList_suspicious.update();
-    for (list<EnsembleTracker*>::iterator it=_tracker_list.begin();it!=_tracker_list.end();)
+    for (vector<TrackerHandle>::iterator it=_tracker_list.begin();it!=_tracker_list.end();)
     {
         if ((*it)->getAddNew() && // has new detection
             (*it)->getHitFreq()*TIME_WINDOW_SIZE<l-sqrt(l) && // low hitting rate
@@ -238,25 +243,73 @@ TrakerManager::TrakerManager(Detector* detector,Mat& frame,double thresh_promoti
         :_detector(detector),
          _my_char(0),
          _frame_count(0),
+         _detected_last_frame(false),
+         _frames_since_keyframe(0),
+         _motion_since_keyframe(0),
+         _detection_round(0),
          _tracker_count(0),
          resultWriter(RESULT_OUTPUT_XML_FILE),
-         _controller(frame.size(),8,8,0.01,1/COUNT_NUM,thresh_promotion)
+         _controller(frame.size(),8,8,0.01,1/COUNT_NUM,thresh_promotion),
+         _track_pool(MAX(TRACKER_THREAD_NUM,1)),
+         _track_log(NULL)
 {
-
+    if (TRACK_LOG)
+        _track_log=new TrackLog(TRACK_LOG_FILE);
 }
 TrakerManager::~TrakerManager()
 {
-    for (list<EnsembleTracker*>::iterator i=_tracker_list.begin();i!=_tracker_list.end();i++)
-        delete *i;
+    for (vector<TrackerHandle>::iterator i=_tracker_list.begin();i!=_tracker_list.end();i++)
+        EnsembleTracker::destroy(*i);
+    delete _track_log;
+}
+/*
+The trackers are tracked in list order: each one reads the occupancy map
+painted by the experts before it, and the state of its neighbors, updated
+for those before it and not yet for those after it. Two trackers can be
+tracked at the same time when neither can see the other this way: one is
+not a neighbor of the other, and the window one may paint its result in does
+not reach the part of the occupancy map the other reads. Each tracker goes
+into the first wave after all the trackers before it it interferes with, so
+running the waves in order gives the same result as the list order.
+*/
+vector<vector<int> > TrakerManager::scheduleTrackers(vector<EnsembleTracker*>& trackers)
+{
+    int n=(int)trackers.size();
+    vector<Rect> read_win(n);
+    vector<Rect> result_win(n);
+    for (int i=0;i<n;i++)
+        trackers[i]->getTrackRegions(read_win[i],result_win[i]);
+
+    vector<int> wave(n,0);
+    int wave_num=0;
+    for (int i=0;i<n;i++)
+    {
+        for (int j=0;j<i;j++)
+        {
+            if (wave[j]<wave[i])
+                continue;
+            bool paints_j= !trackers[j]->getIsNovice() && (result_win[j]&read_win[i]).area()>0;
+            bool paints_i= !trackers[i]->getIsNovice() && (result_win[i]&read_win[j]).area()>0;
+            if (paints_j || paints_i ||
+                trackers[i]->isNeighbor(trackers[j]) || trackers[j]->isNeighbor(trackers[i]))
+                wave[i]=wave[j]+1;
+        }
+        wave_num=MAX(wave_num,wave[i]+1);
+    }
+
+    vector<vector<int> > waves(wave_num);
+    for (int i=0;i<n;i++)
+        waves[wave[i]].push_back(i);
+    return waves;
 }
 void TrakerManager::doHungarianAlg(const vector<Rect>& detections)
 {
     _controller.waitList.update();
 
-    list<EnsembleTracker*> expert_class;
-    list<EnsembleTracker*> novice_class;
+    vector<TrackerHandle> expert_class;
+    vector<TrackerHandle> novice_class;
     vector<Rect> detection_left;
-    for (list<EnsembleTracker*>::iterator it=_tracker_list.begin();it!=_tracker_list.end();it++)
+    for (vector<TrackerHandle>::iterator it=_tracker_list.begin();it!=_tracker_list.end();it++)
     {
         if ((*it)->getIsNovice())
             novice_class.push_back((*it));
@@ -275,7 +328,7 @@ void TrakerManager::doHungarianAlg(const vector<Rect>& detections)
         {
             Rect detect_win_GTsize = scaleWin(detections[i],BODYSIZE_TO_DETECTION_RATIO);
             Rect shrinkWin = scaleWin(detections[i],TRACKING_TO_DETECTION_RATIO);
-            list<EnsembleTracker*>::iterator j_tl = expert_class.begin();
+            vector<TrackerHandle>::iterator j_tl = expert_class.begin();
             for (int j = 0; j < hp_size + dt_size; j++)
             {
                 if (j < hp_size)
@@ -298,28 +351,27 @@ void TrakerManager::doHungarianAlg(const vector<Rect>& detections)
                             matrix(i,j)=d;//*h;
                         }
                         else
-                            matrix(i,j)=INFINITY;
+                            matrix(i,j)=ASSIGNMENT_INFINITY;
                     }
                     else
-                        matrix(i,j)=INFINITY;
+                        matrix(i,j)=ASSIGNMENT_INFINITY;
                     j_tl++;
                 }
                 else
                     matrix(i,j)=100000;// dummy
             }
         }
-        Munkres m;
-        m.solve(matrix);
+        _assignment.solve(matrix);
         for (int i=0;i<dt_size;i++)
         {
             bool flag=false;
-            list<EnsembleTracker*>::iterator j_tl=expert_class.begin();
+            vector<TrackerHandle>::iterator j_tl=expert_class.begin();
             Rect shrinkWin=scaleWin(detections[i],TRACKING_TO_DETECTION_RATIO);
             for (int j=0;j<hp_size;j++)
             {
                 if (matrix(i,j)==0)//matched
                 {
-                    (*j_tl)->addAppTemplate(_frame_set,shrinkWin);//will change result_temp if demoted
+                    (*j_tl)->addAppTemplate(&_frame_set,shrinkWin);//will change result_temp if demoted
                     flag=true;
 
                     if ((*j_tl)->getIsNovice())//release the suspension;
@@ -349,7 +401,7 @@ void TrakerManager::doHungarianAlg(const vector<Rect>& detections)
         {
             Rect detect_win_GTsize=scaleWin(detection_left[i],BODYSIZE_TO_DETECTION_RATIO);
             Rect shrinkWin=scaleWin(detection_left[i],TRACKING_TO_DETECTION_RATIO);
-            list<EnsembleTracker*>::iterator j_tl=novice_class.begin();
+            vector<TrackerHandle>::iterator j_tl=novice_class.begin();
             for (int j=0; j<hp_size+dt_size;j++)
             {
                 if (j<hp_size)
@@ -368,28 +420,27 @@ void TrakerManager::doHungarianAlg(const vector<Rect>& detections)
                         if (dis_to_last/(((double)(*j_tl)->getSuspensionCount()+1)/(FRAME_RATE*5/7)+0.5)<((*j_tl)->getBodysizeResult().width)*2)
                             matrix(i,j)=d;//************could be changed
                         else
-                            matrix(i,j)=INFINITY;
+                            matrix(i,j)=ASSIGNMENT_INFINITY;
                     }
                     else
-                        matrix(i,j)=INFINITY;
+                        matrix(i,j)=ASSIGNMENT_INFINITY;
                     j_tl++;
                 }
                 else
                     matrix(i,j)=100000; // dummy
             }
         }
-        Munkres m;
-        m.solve(matrix);
+        _assignment.solve(matrix);
         for (int i=0;i<dt_size;i++)
         {
             bool flag=false;
-            list<EnsembleTracker*>::iterator j_tl=novice_class.begin();
+            vector<TrackerHandle>::iterator j_tl=novice_class.begin();
             Rect shrinkWin=scaleWin(detection_left[i],TRACKING_TO_DETECTION_RATIO);
             for (int j=0;j<hp_size;j++)
             {
                 if (matrix(i,j)==0)//matched
                 {
-                    (*j_tl)->addAppTemplate(_frame_set,shrinkWin);//will change result_temp if demoted
+                    (*j_tl)->addAppTemplate(&_frame_set,shrinkWin);//will change result_temp if demoted
                     flag=true;
                     if ((*j_tl)->getIsNovice())//release the suspension
                         (*j_tl)->promote();
@@ -412,6 +463,57 @@ void TrakerManager::doHungarianAlg(const vector<Rect>& detections)
             _controller.waitList.feed(scaleWin(detection_left[i],BODYSIZE_TO_DETECTION_RATIO),1.0);
     }
 }
+bool TrakerManager::isKeyframe()
+{
+    if (!ADAPTIVE_DETECTION_INTERVAL)
+        return isDetectionFrame(_frame_count);
+
+    // the interval is the largest gap; detect earlier when the targets move fast
+    if (_frame_count==0 || _frames_since_keyframe+1>=MAX(DETECTION_INTERVAL,1))
+        return true;
+    return _motion_since_keyframe>=KEYFRAME_MOTION_RATIO;
+}
+
+vector<Rect> TrakerManager::getSearchRegions(Size frame_size)
+{
+    vector<Rect> regions;
+    if (!ROI_DETECTION || _detection_round%MAX(FULL_SWEEP_INTERVAL,1)==0)
+        return regions;// periodic full sweep to catch new entries anywhere
+
+    // around the trackers, as far as they can be associated with a detection
+    for (vector<TrackerHandle>::iterator it=_tracker_list.begin();it!=_tracker_list.end();it++)
+    {
+        Rect win=scaleWin((*it)->getBodysizeResult(),1/BODYSIZE_TO_DETECTION_RATIO);
+        int margin=(int)((*it)->getAssRadius()+(*it)->getVel()/FRAME_RATE);
+        regions.push_back(Rect(win.x-margin,win.y-margin,win.width+2*margin,win.height+2*margin));
+    }
+
+    // candidates waiting for enough detections to start a tracker
+    vector<Rect> waiting=_controller.waitList.getWindows();
+    for (size_t i=0;i<waiting.size();i++)
+    {
+        Rect win=scaleWin(waiting[i],1/BODYSIZE_TO_DETECTION_RATIO);
+        regions.push_back(Rect(win.x-win.width,win.y-win.width,3*win.width,win.height+2*win.width));
+    }
+
+    // frame borders, where people enter
+    int bw=(int)(ENTRY_BORDER_RATIO*frame_size.width);
+    int bh=(int)(ENTRY_BORDER_RATIO*frame_size.height);
+    regions.push_back(Rect(0,0,bw,frame_size.height));
+    regions.push_back(Rect(frame_size.width-bw,0,bw,frame_size.height));
+    regions.push_back(Rect(0,0,frame_size.width,bh));
+    regions.push_back(Rect(0,frame_size.height-bh,frame_size.width,bh));
+
+    // the counting zone between lines A and D
+    Point line_pts[]={
+        Point(line_A_x0,line_A_y0),Point(line_A_x1,line_A_y1),
+        Point(line_B_x0,line_B_y0),Point(line_B_x1,line_B_y1),
+        Point(line_C_x0,line_C_y0),Point(line_C_x1,line_C_y1),
+        Point(line_D_x0,line_D_y0),Point(line_D_x1,line_D_y1)};
+    regions.push_back(boundingRect(vector<Point>(line_pts,line_pts+8)));
+
+    return regions;
+}
 
 // Feb 2018 Update: Add Street Crossing Features
 void TrakerManager::counterUpdate(PedestrianPosition ancient, PedestrianPosition curt) {
@@ -474,10 +576,6 @@ PedestrianPosition TrakerManager::getPosition(Point p)
 void TrakerManager::doWork(Mat& frame, int gpu, int frame_n)
 {
 
-    std::vector<int> quality;
-    quality.push_back(CV_IMWRITE_JPEG_QUALITY);
-    quality.push_back(93);
-
     // For each frame:
     line_A_x0 = 229;
     line_A_y0 = 338;
@@ -508,49 +606,37 @@ void TrakerManager::doWork(Mat& frame, int gpu, int frame_n)
 //	    }
 //	}
 
-    Mat bgr,hsv,lab;
-    frame.copyTo(bgr);
-    cvtColor(frame,hsv,CV_RGB2HSV);
-    cvtColor(frame,lab,CV_RGB2Lab);
-    Mat frame_set[]={bgr,hsv,lab};
-    _frame_set = frame_set;
+    // HSV and Lab are converted only where the trackers look (see FrameSet)
+    _frame_set.setFrame(frame);
 
-    // resize the input image and detect objects
-    _occupancy_map=Mat(frame.rows,frame.cols,CV_8UC1,Scalar(0));
+    // on keyframes, resize the input image and detect objects; other frames only track
+    bool keyframe=isKeyframe();
+    if (keyframe)
+    {
+        _frames_since_keyframe=0;
+        _motion_since_keyframe=0;
+    }
+    else
+        _frames_since_keyframe++;
+
+    _occupancy_map.reset(frame.size());
     Mat frame_resize;
-    resize(frame,frame_resize,
-           Size((int)(frame.cols*HOG_DETECT_FRAME_RATIO),
-                (int)(frame.rows*HOG_DETECT_FRAME_RATIO)));
-    //	_detector->detect(frame_resize, gpu);// NOTE: the detections are resized into the normal size
-    //vector<Rect> detections=_detector->getDetection();
-    //vector<double> response=_detector->getResponse();
+    if (keyframe)
+    {
+        _detector->setSearchRegions(getSearchRegions(frame.size()));
+        _detection_round++;
+        if (_detector->needsFrame())
+            resize(frame,frame_resize,
+                   Size((int)(frame.cols*HOG_DETECT_FRAME_RATIO),
+                        (int)(frame.rows*HOG_DETECT_FRAME_RATIO)));
+        _detector->detect(frame_resize, gpu);// NOTE: the detections are resized into the normal size
+    }
+    else
+        _detector->skip();
+    vector<Rect> detections=_detector->getDetection();
+    vector<double> response=_detector->getResponse();
     vector<int> det_filter;
 
-    //bo: create detect based on the result of YOLO
-    vector<Rect> detections;
-    vector<double> response;
-
-    int framec;
-    ifstream file;
-    file.open("../darknet/det.txt");
-
-
-    while (file.is_open() && file >> framec) {
-        int x1, y1, x2, y2, c;
-        file >> x1;
-        file >> y1;
-        file >> x2;
-        file >> y2;
-        file >> c;
-        //cout << "*** " << framec << " " << x1 << " " << y1 << " " << x2 << " " << y2 << endl;
-        if (framec == frame_n) {
-            Point p1(x1, y1);
-            Point p2(x2, y2);
-            Rect rec(p1, p2);
-            detections.push_back(rec);
-        }
-        if (framec > frame_n) break;
-    }
     //filter the detection
     if (detections.size()>0)
     {
@@ -578,104 +664,152 @@ void TrakerManager::doWork(Mat& frame, int gpu, int frame_n)
         if (det_filter[k]!=BAD)
             good_detections.push_back(detections[k]);
     }
-    // empty the trash bin of removed trackers
-    EnsembleTracker::emptyTrash();
-
+    // the templates of this frame are learned around the detections
+    vector<Rect> template_rois;
+    for (size_t k=0;k<good_detections.size();k++)
+        template_rois.push_back(AppTemplate::getRoiWin(scaleWin(good_detections[k],TRACKING_TO_DETECTION_RATIO)));
+    _frame_set.setHistogramRegions(template_rois);
     //4,5 termination update matching rate
-    _controller.takeVoteForAvgHittingRate(_tracker_list); // calculate the average hitting rate
-    _controller.getQualifiedCandidates();
-    _controller.deleteObsoleteTracker(_tracker_list);
-    _controller.calcSuspiciousArea(_tracker_list);
-
-	// draw detections
-	for (size_t it=0;it<detections.size();it++)
-	{
-		if (det_filter[it]!=BAD)
-			rectangle(frame,detections[it],Scalar(0,255,127),2);
-		else
-			rectangle(frame,detections[it],Scalar(0,255,127),1);
-	}
-
-    //for each tracker, do tracking, tracker and template management
+    //the votes are on the association of the last frame, so a frame without detection has nothing to count
+    if (_detected_last_frame)
+    {
+        _controller.takeVoteForAvgHittingRate(_tracker_list); // calculate the average hitting rate
+        _controller.getQualifiedCandidates();
+        _controller.deleteObsoleteTracker(_tracker_list);
+        _controller.calcSuspiciousArea(_tracker_list);
+    }
+
+    // record what is drawn on this frame (see Renderer)
+    _snapshot=FrameSnapshot();
+    _snapshot.frame=frame;
+    _snapshot.frame_n=frame_n;
+    _snapshot.detections=detections;
+    for (size_t it=0;it<detections.size();it++)
+        _snapshot.good_detection.push_back(det_filter[it]!=BAD);
+
+    //for each tracker, do tracking and template management, in waves on the thread pool (see scheduleTrackers)
     //cout << _tracker_list.size() << endl;
-    for (list<EnsembleTracker*>::iterator i=_tracker_list.begin();i!=_tracker_list.end();)
+    vector<EnsembleTracker*> trackers;
+    for (vector<TrackerHandle>::iterator i=_tracker_list.begin();i!=_tracker_list.end();i++)
+        trackers.push_back(i->get());
+    // the kalman prediction of this frame, for all the trackers in one pass
+    _kalman_batch.resize((int)trackers.size());
+    for (size_t k=0;k<trackers.size();k++)
+        _kalman_batch.gather((int)k,trackers[k]->getKalmanFilter());
+    _kalman_batch.predict();
+    for (size_t k=0;k<trackers.size();k++)
+        _kalman_batch.scatter((int)k,trackers[k]->getKalmanFilter());
+    vector<vector<int> > waves=scheduleTrackers(trackers);
+    for (size_t w=0;w<waves.size();w++)
     {
-        (*i)->calcConfidenceMap(_frame_set,_occupancy_map);
-        (*i)->track(_frame_set,_occupancy_map);
-        (*i)->calcScore();
-        (*i)->deletePoorTemplate(0.0);
+        const vector<int>& wave=waves[w];
+        _track_pool.parallelFor((int)wave.size(),[&](int k)
+        {
+            EnsembleTracker* tracker=trackers[wave[k]];
+            tracker->calcConfidenceMap(&_frame_set,&_occupancy_map);
+            tracker->track(&_frame_set,&_occupancy_map,keyframe);
+            tracker->calcScore(&_frame_set);
+            tracker->deletePoorTemplate(0.0);
+        });
+
+        //update occupancy map.
+        //Note: demotion is delayed by one frame, so checking template number could help.
+        for (size_t k=0;k<wave.size();k++)
+        {
+            EnsembleTracker* tracker=trackers[wave[k]];
+            if (!tracker->getIsNovice() && tracker->getTemplateNum()>0)
+                _occupancy_map.occupy(tracker->getResult());
+        }
+    }
 
+    //tracker management, in list order
+    _neighbor_grid.build(_tracker_list,Size(_frame_set.cols(),_frame_set.rows()));
+    size_t kept=0;
+    for (size_t k=0;k<_tracker_list.size();k++)
+    {
+        TrackerHandle tracker=_tracker_list[k];
         // update neighbors
-        (*i)->updateNeighbors(_tracker_list);
+        tracker->updateNeighbors(_neighbor_grid);
+        tracker->finishTrack();
+        _neighbor_grid.update(tracker.get());
 
         // moving experts will vote for the body height map
-        if (!(*i)->getIsNovice() && (*i)->getVel()>(*i)->getBodysizeResult().width*0.42)
-            _controller.takeVoteForHeight((*i)->getBodysizeResult());
+        if (!tracker->getIsNovice() && tracker->getVel()>tracker->getBodysizeResult().width*0.42)
+            _controller.takeVoteForHeight(tracker->getBodysizeResult());
 
-        //update occupancy map.
-        //Note: demotion is delayed by one frame, so checking template number could help.
-        if (!(*i)->getIsNovice() && (*i)->getTemplateNum()>0)
-            rectangle(_occupancy_map,(*i)->getResult(),Scalar(1),-1);
+        // scene motion for the adaptive detection interval
+        if (!tracker->getIsNovice())
+            _motion_since_keyframe=MAX(_motion_since_keyframe,
+                                       _frames_since_keyframe*tracker->getVel()/FRAME_RATE/tracker->getBodysizeResult().width);
 
         //kill the tracker if it gets out of border
-        Rect avgWin=(*i)->getResult();
+        Rect avgWin=tracker->getResult();
         if (avgWin.x<=0 ||
-            avgWin.x+avgWin.width>=_frame_set[0].cols-1 ||
+            avgWin.x+avgWin.width>=_frame_set.cols()-1 ||
             avgWin.y<=0 ||
-            avgWin.y+avgWin.height>=_frame_set[0].rows-1)
+            avgWin.y+avgWin.height>=_frame_set.rows()-1)
         {
-            (*i)->refcDec1();
-            (*i)->dump();
-            _tracker_list.erase(i++);
+            _neighbor_grid.remove(tracker.get());
+            EnsembleTracker::destroy(tracker);
             continue;
         }
-        i++;
+        _tracker_list[kept++]=tracker;
     }
+    _tracker_list.erase(_tracker_list.begin()+kept,_tracker_list.end());
 
-    // do detection association, and promote trackers here
-    doHungarianAlg(good_detections);
-
-    //start new trackers
-    vector<Rect> qualified=_controller.getQualifiedCandidates();
-    for (size_t i=0;i<qualified.size();i++)
+    if (keyframe)
     {
-        if (_tracker_list.size()<MAX_TRACKER_NUM)
+        // do detection association, and promote trackers here
+        doHungarianAlg(good_detections);
+
+        //start new trackers
+        vector<Rect> qualified=_controller.getQualifiedCandidates();
+        for (size_t i=0;i<qualified.size();i++)
         {
-            EnsembleTracker* tracker=new EnsembleTracker(_tracker_count,Size(qualified[i].width,qualified[i].height));
-            tracker->refcAdd1();
-            Rect iniWin=scaleWin(qualified[i],TRACKING_TO_BODYSIZE_RATIO);
-            tracker->addAppTemplate(_frame_set,iniWin);
-            _tracker_list.push_back(tracker);
-            _tracker_count++;
+            if (_tracker_list.size()<MAX_TRACKER_NUM)
+            {
+                TrackerHandle tracker=EnsembleTracker::create(_tracker_count,Size(qualified[i].width,qualified[i].height));
+                Rect iniWin=scaleWin(qualified[i],TRACKING_TO_BODYSIZE_RATIO);
+                tracker->addAppTemplate(&_frame_set,iniWin);
+                _tracker_list.push_back(tracker);
+                _tracker_count++;
+            }
         }
     }
+    _detected_last_frame=keyframe;
 
     int max = 0;
 
     // register results and draw
     vector<Result2D> output;
+    vector<TrackLogRecord> log_records;
 
     char location[6][12] = {"VP_NONE","A_Left","AB", "BC", "CD", "D_Right"};
 
-    for (list<EnsembleTracker*>::iterator i =_tracker_list.begin(); i !=_tracker_list.end(); i++)
+    for (vector<TrackerHandle>::iterator i =_tracker_list.begin(); i !=_tracker_list.end(); i++)
     {
         // Check position for each results!
 
         (*i)->registerTrackResult();//record the final output!!!
+        if (_track_log!=NULL)
+        {
+            Rect win=(*i)->getResultHistory().back();
+            TrackLogRecord record={frame_n,(*i)->getID(),(short)win.x,(short)win.y,(short)win.width,(short)win.height,(*i)->getIsNovice()};
+            log_records.push_back(record);
+        }
         if (!(*i)->getIsNovice())
         {
-            (*i)->updateMatchHist(bgr);
+            (*i)->updateMatchHist(frame);
         }
         if ((*i)->getResultHistory().size()>=0)
         {
             //(*i)->drawResult(frame);
-            if (!(*i)->getIsNovice() || ((*i)->getIsNovice() && (*i)->compareHisto(bgr,(*i)->getBodysizeResult())>HIST_MATCH_THRESH_CONT))//***************
+            if (!(*i)->getIsNovice() || ((*i)->getIsNovice() && (*i)->compareHisto(frame,(*i)->getBodysizeResult())>HIST_MATCH_THRESH_CONT))//***************
             {
-                (*i)->drawResult(frame, 1 / TRACKING_TO_BODYSIZE_RATIO);
-
                 // These are all about result export
                 Rect win = (*i)->getResultHistory().back();
                 int id = (*i)->getID();
+                _snapshot.tracks.push_back(TrackSnapshot(win,id,(*i)->getIsNovice()));
                 Point centroid(win.x + 3, win.y + 3);
 
                 // 1. Insert this Pedestrian's info into curtPosition
@@ -732,38 +866,19 @@ void TrakerManager::doWork(Mat& frame, int gpu, int frame_n)
                             }
                             
                             cout << "id=" << id << " crossing from " << location[ancient] << " to " << location[curt] << endl;
-                            Mat tmp = frame.clone();
-
-                            // 6. Only show circle when it hits the line
-                            cv::circle(tmp, centroid, 5, cv::Scalar(255, 255, 255), 5);
 
-                            std::string countABstr = "Cross A -> B: " + std::to_string(countAB);
-                            std::string countBAstr = "Cross B -> A: " + std::to_string(countBA);
-                            std::string countCDstr = "Cross C -> D: " + std::to_string(countCD);
-                            std::string countDCstr = "Cross D -> C: " + std::to_string(countDC);
+                            // 6. The renderer saves a picture of the crossing
+                            TrackSnapshot& t = _snapshot.tracks.back();
+                            t.crossed = true;
+                            t.counts[0] = countAB;
+                            t.counts[1] = countBA;
+                            t.counts[2] = countCD;
+                            t.counts[3] = countDC;
                             int countTotal = countAB + countBA + countCD + countDC;
-                            std::string total = "Total: " + std::to_string(countTotal);
-                            cv::putText(tmp, countABstr, cv::Point(5, 75), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-                            cv::putText(tmp, countBAstr, cv::Point(5, 100), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-                            cv::putText(tmp, countCDstr, cv::Point(5, 125), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-                            cv::putText(tmp, countDCstr, cv::Point(5, 150), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-                            cv::putText(tmp, total, cv::Point(5, 175), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-                            std::string address = to_string(countTotal) + "-Frame-" + std::to_string(frame_n) + "-id-" + std::to_string(id) + "-" + location[ancient] + "-" + location[curt] + ".jpg";
-                            bool bSuccess = cv::imwrite(address, tmp, quality);
-                            if (!bSuccess){
-                                std::cout << "Error: Failed to save the image" << std::endl;
-                            }
+                            t.crossing_file = to_string(countTotal) + "-Frame-" + std::to_string(frame_n) + "-id-" + std::to_string(id) + "-" + location[ancient] + "-" + location[curt] + ".jpg";
                         }
                     }
                 }
-
-                Point tx(win.x + 10, win.y - 10);
-                char buff[10];
-                sprintf(buff, "%d", id);
-                string s = buff;
-                //C++: void putText(Mat& img, const string& text, Point org, int fontFace, double fontScale, Scalar color, int thickness=1, int lineType=8, bool bottomLeftOrigin=false)
-//				putText(frame, s, tx, FONT_HERSHEY_PLAIN, 2, COLOR((*i)->getID()), 2);
-                putText(frame, s, tx, FONT_HERSHEY_COMPLEX_SMALL, 1, cv::Scalar(255, 0, 0), 2);
 /*
 
 				//&&&&&
@@ -794,45 +909,33 @@ void TrakerManager::doWork(Mat& frame, int gpu, int frame_n)
     }
 
     // sort trackers based on number of templates
-    _tracker_list.sort(TrakerManager::compareTraGroup);
+    stable_sort(_tracker_list.begin(),_tracker_list.end(),TrakerManager::compareTraGroup);
 
     // record results to xml file
     resultWriter.putNextFrameResult(output);
+    if (_track_log!=NULL)
+        _track_log->putNextFrameResult(log_records);
 
     // screen shot
     if (_my_char=='g')
     {
-        char buff[20];
-        sprintf(buff,"%d.jpg",_frame_count);
-        string filename=buff;
-        imwrite(filename,frame);
+        _snapshot.screenshot=true;
+        _snapshot.frame_n=_frame_count;
         _my_char=0;
     }
 
-    cv::putText(frame, "A", cv::Point(line_A_x1 + 3, line_A_y1 + 25), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-    cv::putText(frame, "B", cv::Point(line_B_x1 + 3, line_B_y1 + 25), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-    cv::putText(frame, "C", cv::Point(line_C_x1 + 3, line_C_y1 + 25), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-    cv::putText(frame, "D", cv::Point(line_D_x1 + 3, line_D_y1 + 25), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
-    // Line A
-    line(frame, Point(229, 338), Point(663, 456), Scalar(0, 0, 255), 2, 8);
-    // Line B
-    line(frame, Point(341, 326), Point(940, 449), Scalar(0, 0, 255), 2, 8);
-    // Line C
-    line(frame, Point(408, 304), Point(1021, 392), Scalar(0, 0, 255), 2, 8);
-    // Line D
-    line(frame, Point(458, 295), Point(1086, 373), Scalar(0, 0, 255), 2, 8);
-
-    std::string countABstr = "Cross A -> B: " + std::to_string(countAB);
-    std::string countBAstr = "Cross B -> A: " + std::to_string(countBA);
-    std::string countCDstr = "Cross C -> D: " + std::to_string(countCD);
-    std::string countDCstr = "Cross D -> C: " + std::to_string(countDC);
-    int countTotal = countAB + countBA + countCD + countDC;
-    std::string total = "Total: " + std::to_string(countTotal);
-    cv::putText(frame, countABstr, cv::Point(5, 75), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
-    cv::putText(frame, countBAstr, cv::Point(5, 100), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
-    cv::putText(frame, countCDstr, cv::Point(5, 125), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
-    cv::putText(frame, countDCstr, cv::Point(5, 150), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
-    cv::putText(frame, total, cv::Point(5, 175), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
+    _snapshot.lines[0][0]=Point(line_A_x0,line_A_y0);
+    _snapshot.lines[0][1]=Point(line_A_x1,line_A_y1);
+    _snapshot.lines[1][0]=Point(line_B_x0,line_B_y0);
+    _snapshot.lines[1][1]=Point(line_B_x1,line_B_y1);
+    _snapshot.lines[2][0]=Point(line_C_x0,line_C_y0);
+    _snapshot.lines[2][1]=Point(line_C_x1,line_C_y1);
+    _snapshot.lines[3][0]=Point(line_D_x0,line_D_y0);
+    _snapshot.lines[3][1]=Point(line_D_x1,line_D_y1);
+    _snapshot.counts[0]=countAB;
+    _snapshot.counts[1]=countBA;
+    _snapshot.counts[2]=countCD;
+    _snapshot.counts[3]=countDC;
 
     // Execute deep copy from curtPosition to prevPosition
     ancientPositions = earlyPositions;
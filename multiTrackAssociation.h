@@ -35,6 +35,11 @@
 #include "util.h"
 #include "tracker.h"
 #include "detector.h"
+#include "renderer.h"
+#include "threadUtil.h"
+#include "trackLog.h"
+#include "rollingSum.h"
+#include "lapjv.h"
 
 #define GOOD 0
 #define NOTSURE 1
@@ -42,6 +47,8 @@
 
 #define COUNT_NUM 1000.0
 #define SLIDING_WIN_SIZE 7.2 * TIME_WINDOW_SIZE
+#define KEYFRAME_MOTION_RATIO 0.5 // adaptive interval: body widths the fastest tracker may move between keyframes
+#define ENTRY_BORDER_RATIO 0.1 // region detection: width of the frame border strips where people enter
 
 using namespace cv;
 
@@ -74,7 +81,7 @@ class WaitingList
 		}
 	}Waiting;
 
-	list<Waiting> w_list;
+	vector<Waiting> w_list;
 	int life_limit;
 
 public:
@@ -82,6 +89,7 @@ public:
 	void update();
 	vector<Rect>outputQualified(double thresh);
 	void feed(Rect bodysize_win,double response);
+	vector<Rect> getWindows();
 };
 
 class Controller
@@ -96,14 +104,14 @@ public:
 		double thresh_expert=0.5);
 	void takeVoteForHeight(Rect bodysize_win);	
 	vector<int> filterDetection(vector<Rect> detction_bodysize);	
-	void takeVoteForAvgHittingRate(list<EnsembleTracker*> _tracker_list);	
+	void takeVoteForAvgHittingRate(vector<TrackerHandle>& _tracker_list);	
 
 	/*
 	Tracker death control. For modifying termination conditions, change here.
 	*/
-	void deleteObsoleteTracker(list<EnsembleTracker*>& _tracker_list);	
+	void deleteObsoleteTracker(vector<TrackerHandle>& _tracker_list);	
 	
-	void calcSuspiciousArea(list<EnsembleTracker*>& _tracker_list);	
+	void calcSuspiciousArea(vector<TrackerHandle>& _tracker_list);	
 	inline vector<Rect> getQualifiedCandidates()
 	{
 		/*
@@ -113,27 +121,18 @@ public:
 		return waitList.outputQualified((l-sqrt(l)-1.0));		
 	}
 private:
-	// a rotate array for keep record of the average hitting rate
+	// the last votes, for the average hitting rate
 	typedef struct HittingRecord
 	{
-		Mat record;
-		int idx;
-		HittingRecord():idx(0)
-		{
-			record=Mat::zeros(2,(int)(SLIDING_WIN_SIZE),CV_64FC1);
-		}
+		RollingSum<int> votes;
+		HittingRecord():votes((size_t)MAX((int)(SLIDING_WIN_SIZE),1)){}
 		void recordVote(bool vote)
 		{
-			idx=idx-record.cols*(idx/record.cols);
-			record.at<double>(0,idx)=vote ? 1.0:0;
-			record.at<double>(1,idx)=1;
-			idx++;
+			votes.push(vote ? 1:0);
 		}
 		double _getAvgHittingRate(double _alpha_hitting_rate, double _beta_hitting_rate)
 		{
-			Scalar s1=sum(record.row(0));
-			Scalar s2=sum(record.row(1));
-			return (s1[0]*TIME_WINDOW_SIZE+_alpha_hitting_rate)/(_beta_hitting_rate+s2[0]);
+			return (votes.sum()*TIME_WINDOW_SIZE+_alpha_hitting_rate)/(_beta_hitting_rate+votes.size());
 		}
 	}HittingRecord;
 
@@ -206,6 +205,7 @@ public:
 	~TrakerManager();
 
 	void doWork(Mat& frame, int gpu, int frame_n);
+	inline const FrameSnapshot& getSnapshot(){return _snapshot;}//what to draw for the last frame
 
 	void setKey(char c)
 	{
@@ -217,22 +217,37 @@ private:
 	void counterUpdate(PedestrianPosition prev, PedestrianPosition curt);
 
 	void doHungarianAlg(const vector<Rect>& detections);
-	inline static bool compareTraGroup(EnsembleTracker* c1,EnsembleTracker* c2)
+	bool isKeyframe();
+	vector<Rect> getSearchRegions(Size frame_size);//empty for a full frame sweep
+	vector<vector<int> > scheduleTrackers(vector<EnsembleTracker*>& trackers);//waves of trackers that can be tracked at the same time
+	inline static bool compareTraGroup(TrackerHandle c1,TrackerHandle c2)
 	{
 		return c1->getTemplateNum()>c2->getTemplateNum() ? true:false;
 	}
 
 	Controller _controller;
-	Mat* _frame_set;
-	list<EnsembleTracker*> _tracker_list;
+	FrameSet _frame_set;//feature channels of the current frame
+	vector<TrackerHandle> _tracker_list;
 	int _tracker_count;
 	char _my_char;		
 	
 	Detector* _detector;
 	int _frame_count;
+
+	// detection schedule (see DETECTION_INTERVAL)
+	bool _detected_last_frame;
+	int _frames_since_keyframe;
+	double _motion_since_keyframe;//largest displacement in body widths
+	int _detection_round;//number of keyframes so far
 	
-	Mat _occupancy_map;	
+	OccupancyMap _occupancy_map;	
 	XMLBBoxWriter resultWriter;
+	TrackLog* _track_log;//NULL without TRACK_LOG
+	FrameSnapshot _snapshot;
+	ThreadPool _track_pool;//for the tracker updates, see scheduleTrackers()
+	KalmanBatch _kalman_batch;//the kalman prediction of all the trackers
+	NeighborGrid _neighbor_grid;//for updateNeighbors()
+	LapJV _assignment;//for doHungarianAlg()
 
 	double _thresh_for_expert_;
 };
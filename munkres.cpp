@@ -34,8 +34,8 @@ Munkres::find_uncovered_in_matrix(double item, int &row, int &col) {
 }
 
 bool 
-Munkres::pair_in_list(const std::pair<int,int> &needle, const std::list<std::pair<int,int> > &haystack) {
-  for ( std::list<std::pair<int,int> >::const_iterator i = haystack.begin() ; i != haystack.end() ; i++ ) {
+Munkres::pair_in_list(const std::pair<int,int> &needle, const std::vector<std::pair<int,int> > &haystack) {
+  for ( std::vector<std::pair<int,int> >::const_iterator i = haystack.begin() ; i != haystack.end() ; i++ ) {
     if ( needle == *i )
       return true;
   }
@@ -138,12 +138,12 @@ Munkres::step4(void) {
   int rows = matrix.rows();
   int cols = matrix.columns();
 
-  std::list<std::pair<int,int> > seq;
+  std::vector<std::pair<int,int> > seq;
   // use saverow, savecol from step 3.
   std::pair<int,int> z0(saverow, savecol);
   std::pair<int,int> z1(-1,-1);
   std::pair<int,int> z2n(-1,-1);
-  seq.insert(seq.end(), z0);
+  seq.push_back(z0);
   int row, col = savecol;
   /*
   Increment Set of Starred Zeros
@@ -168,7 +168,7 @@ Munkres::step4(void) {
           continue;
         
         madepair = true;
-        seq.insert(seq.end(), z1);
+        seq.push_back(z1);
         break;
       }
 
@@ -184,12 +184,12 @@ Munkres::step4(void) {
         if ( pair_in_list(z2n, seq) )
           continue;
         madepair = true;
-        seq.insert(seq.end(), z2n);
+        seq.push_back(z2n);
         break;
       }
   } while ( madepair );
 
-  for ( std::list<std::pair<int,int> >::iterator i = seq.begin() ;
+  for ( std::vector<std::pair<int,int> >::iterator i = seq.begin() ;
       i != seq.end() ;
       i++ ) {
     // 2. Unstar each starred zero of the sequence.
@@ -21,8 +21,9 @@
 
 #include "matrix.h"
 
-#include <list>
+#include <vector>
 #include <utility>
+#undef INFINITY // <cmath>'s, this one is a finite cost
 #define INFINITY 1000000000
 class Munkres {
 public:
@@ -32,7 +33,7 @@ private:
   static const int STAR = 1;
   static const int PRIME = 2; 
 	inline bool find_uncovered_in_matrix(double,int&,int&);
-	inline bool pair_in_list(const std::pair<int,int> &, const std::list<std::pair<int,int> > &);
+	inline bool pair_in_list(const std::pair<int,int> &, const std::vector<std::pair<int,int> > &);
 	int step1(void);
 	int step2(void);
 	int step3(void);
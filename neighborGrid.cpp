@@ -0,0 +1,102 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include <algorithm>
+
+#include "neighborGrid.h"
+#include "tracker.h"
+
+static bool compareID(EnsembleTracker* t1, EnsembleTracker* t2)
+{
+	return t1->getID()<t2->getID();
+}
+
+Point NeighborGrid::getCenter(EnsembleTracker* tracker)
+{
+	Rect r=tracker->getNeighborBodysize();
+	return Point((int)(r.x+0.5*r.width),(int)(r.y+0.5*r.height));
+}
+int NeighborGrid::getCell(Point p)
+{
+	return clampRow(p.y)*_grid_cols+clampCol(p.x);
+}
+void NeighborGrid::build(const vector<TrackerHandle>& trackers, Size frame_size)
+{
+	double width_sum=0;
+	for (vector<TrackerHandle>::const_iterator it=trackers.begin();it!=trackers.end();it++)
+		width_sum+=(*it)->getNeighborBodysize().width;
+	_cell_size=trackers.empty() ? 1.0 : MAX(width_sum/trackers.size(),1.0);
+	_grid_cols=MAX((int)ceil(frame_size.width/_cell_size),1);
+	_grid_rows=MAX((int)ceil(frame_size.height/_cell_size),1);
+
+	_cells.assign(_grid_cols*_grid_rows,vector<EnsembleTracker*>());
+	_cell_of.clear();
+	for (vector<TrackerHandle>::const_iterator it=trackers.begin();it!=trackers.end();it++)
+	{
+		EnsembleTracker* tracker=it->get();
+		int cell=getCell(getCenter(tracker));
+		_cells[cell].push_back(tracker);
+		_cell_of[tracker]=cell;
+	}
+}
+void NeighborGrid::update(EnsembleTracker* tracker)
+{
+	unordered_map<EnsembleTracker*,int>::iterator it=_cell_of.find(tracker);
+	if (it==_cell_of.end())
+		return;
+	int cell=getCell(getCenter(tracker));
+	if (cell==it->second)
+		return;
+	vector<EnsembleTracker*>& old_cell=_cells[it->second];
+	old_cell.erase(find(old_cell.begin(),old_cell.end(),tracker));
+	_cells[cell].push_back(tracker);
+	it->second=cell;
+}
+void NeighborGrid::remove(EnsembleTracker* tracker)
+{
+	unordered_map<EnsembleTracker*,int>::iterator it=_cell_of.find(tracker);
+	if (it==_cell_of.end())
+		return;
+	vector<EnsembleTracker*>& cell=_cells[it->second];
+	cell.erase(find(cell.begin(),cell.end(),tracker));
+	_cell_of.erase(it);
+}
+void NeighborGrid::query(Point2d center, double radius, vector<EnsembleTracker*>& result)
+{
+	result.clear();
+	if (_cells.empty() || !(radius>=0))
+		return;
+	int c0=clampCol(center.x-radius), c1=clampCol(center.x+radius);
+	int r0=clampRow(center.y-radius), r1=clampRow(center.y+radius);
+	for (int r=r0;r<=r1;r++)
+	{
+		for (int c=c0;c<=c1;c++)
+		{
+			const vector<EnsembleTracker*>& cell=_cells[r*_grid_cols+c];
+			result.insert(result.end(),cell.begin(),cell.end());
+		}
+	}
+	sort(result.begin(),result.end(),compareID);
+}
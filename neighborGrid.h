@@ -0,0 +1,76 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef NEIGHBOR_GRID_H
+#define NEIGHBOR_GRID_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "opencv2/opencv.hpp"
+
+using namespace cv;
+using namespace std;
+
+class EnsembleTracker;
+class TrackerHandle;
+
+/*
+Neighbor Grid:
+A uniform grid over the frame of the trackers' body centers, as seen by
+EnsembleTracker::updateNeighbors() (getNeighborBodysize()). TrakerManager
+builds it once per frame; a tracker whose center changes or that is removed
+is moved or removed so that the grid always holds the trackers of the list.
+A query only visits the cells around a circle. Centers outside the frame go
+into the border cells.
+*/
+class NeighborGrid
+{
+public:
+	NeighborGrid():_cell_size(1),_grid_cols(0),_grid_rows(0){}
+	void build(const vector<TrackerHandle>& trackers, Size frame_size);//cell size: the average body width
+	void update(EnsembleTracker* tracker);//its center may have changed
+	void remove(EnsembleTracker* tracker);
+	// the trackers whose center may be within radius of center, in ID order; the exact distance is for the caller to check
+	void query(Point2d center, double radius, vector<EnsembleTracker*>& result);
+	static Point getCenter(EnsembleTracker* tracker);//the center the grid uses
+
+private:
+	int getCell(Point p);
+	inline int clampCell(double v, int n)
+	{
+		double c=floor(v/_cell_size);
+		return c<0 ? 0 : (c>=n ? n-1 : (int)c);
+	}
+	inline int clampCol(double x){return clampCell(x,_grid_cols);}
+	inline int clampRow(double y){return clampCell(y,_grid_rows);}
+
+	double _cell_size;
+	int _grid_cols,_grid_rows;
+	vector<vector<EnsembleTracker*> > _cells;
+	unordered_map<EnsembleTracker*,int> _cell_of;
+};
+
+#endif
@@ -0,0 +1,150 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <stdint.h>
+#include <new>
+#include <vector>
+#include <mutex>
+#include <utility>
+#include <type_traits>
+
+using namespace std;
+
+/*
+Pool Handle:
+Refers to an object of an ObjectPool by its slot and the generation of the
+slot when the object was created.
+*/
+typedef struct PoolHandle
+{
+	uint32_t index;
+	uint32_t generation;
+	PoolHandle():index(UINT32_MAX),generation(0){}
+	PoolHandle(uint32_t i,uint32_t g):index(i),generation(g){}
+	inline bool operator==(const PoolHandle& h) const {return index==h.index && generation==h.generation;}
+	inline bool operator!=(const PoolHandle& h) const {return !(*this==h);}
+}PoolHandle;
+
+/*
+Object Pool:
+A slab allocator for the objects of one type. The slots are allocated
+SLAB_SIZE at a time and never moved or freed while the pool lives; the slot
+of a destroyed object is the next one create() uses, so a long run does not
+fragment the heap. Destroying an object increases the generation of its
+slot, after which get() of a handle made before gives NULL. create() and
+destroy() may be called from several threads; get() may be too, as long as
+no create() runs at the same time.
+*/
+template<class T, int SLAB_SIZE=64>
+class ObjectPool
+{
+public:
+	ObjectPool(){}
+	~ObjectPool()
+	{
+		for (size_t s=0;s<_slabs.size();s++)
+		{
+			for (int i=0;i<SLAB_SIZE;i++)
+				if (_slabs[s][i].alive)
+					_slabs[s][i].object()->~T();
+			delete [] _slabs[s];
+		}
+	}
+	template<class... Args>
+	T* create(Args&&... args)
+	{
+		Slot* slot;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_free.empty())
+				addSlab();
+			slot=_free.back();
+			_free.pop_back();
+		}
+		// the construction of the object does not need the lock
+		new (&slot->storage) T(std::forward<Args>(args)...);
+		slot->alive=true;
+		return slot->object();
+	}
+	void destroy(T* object)
+	{
+		if (object==NULL)
+			return;
+		Slot* slot=reinterpret_cast<Slot*>(object);
+		object->~T();
+		std::lock_guard<std::mutex> lock(_mutex);
+		slot->alive=false;
+		slot->generation++;
+		_free.push_back(slot);
+	}
+	inline PoolHandle getHandle(T* object) const
+	{
+		const Slot* slot=reinterpret_cast<const Slot*>(object);
+		return PoolHandle(slot->index,slot->generation);
+	}
+	inline T* get(PoolHandle h) const//NULL when the object is destroyed
+	{
+		if (h.index>=_slabs.size()*SLAB_SIZE)
+			return NULL;
+		Slot& slot=_slabs[h.index/SLAB_SIZE][h.index%SLAB_SIZE];
+		return slot.generation==h.generation && slot.alive ? slot.object() : NULL;
+	}
+
+private:
+	typedef struct Slot
+	{
+		typename aligned_storage<sizeof(T),alignof(T)>::type storage;//the object, first so a pointer to it is a pointer to the slot
+		uint32_t index;
+		uint32_t generation;
+		bool alive;
+		inline T* object(){return reinterpret_cast<T*>(&storage);}
+	}Slot;
+
+	ObjectPool(const ObjectPool&);
+	ObjectPool& operator=(const ObjectPool&);
+	void addSlab()
+	{
+		Slot* slab=new Slot[SLAB_SIZE];
+		uint32_t base=(uint32_t)(_slabs.size()*SLAB_SIZE);
+		// the free slots are taken from the back, lowest index first
+		for (int i=SLAB_SIZE-1;i>=0;i--)
+		{
+			slab[i].index=base+i;
+			slab[i].generation=0;
+			slab[i].alive=false;
+			_free.push_back(&slab[i]);
+		}
+		_slabs.push_back(slab);
+	}
+
+	vector<Slot*> _slabs;
+	vector<Slot*> _free;
+	std::mutex _mutex;
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include "occupancyMap.h"
+
+void OccupancyMap::reset(Size frame_size)
+{
+	_size=frame_size;
+	_rects.clear();
+}
+void OccupancyMap::occupy(Rect win)
+{
+	win&=Rect(0,0,_size.width,_size.height);
+	if (win.area()>0)
+		_rects.push_back(win);
+}
+void OccupancyMap::getMask(Rect win, Mat& mask)
+{
+	mask.create(win.height,win.width,CV_8UC1);
+	mask.setTo(Scalar(0));
+	for (size_t i=0;i<_rects.size();i++)
+	{
+		Rect r=_rects[i]&win;
+		if (r.area()>0)
+			mask(r-Point(win.x,win.y)).setTo(Scalar(1));
+	}
+}
+bool OccupancyMap::isOccupied(Point p)
+{
+	for (size_t i=0;i<_rects.size();i++)
+	{
+		if (_rects[i].contains(p))
+			return true;
+	}
+	return false;
+}
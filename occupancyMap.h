@@ -0,0 +1,58 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef OCCUPANCY_MAP_H
+#define OCCUPANCY_MAP_H
+
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+using namespace cv;
+using namespace std;
+
+/*
+Occupancy Map:
+The parts of the frame taken by the experts tracked so far in a frame (see
+TrakerManager::doWork). A tracker does not need the whole map: getMask()
+gives the part under its window, to which the tracker adds its own masks.
+The map keeps the occupied rectangles rather than a frame-sized mask, so
+neither clearing it nor reading a window depends on the size of the frame.
+*/
+class OccupancyMap
+{
+public:
+	void reset(Size frame_size);//nothing occupied
+	void occupy(Rect win);
+	void getMask(Rect win, Mat& mask);//mask of win (inside the frame): 1 for occupied, 0 for free
+	bool isOccupied(Point p);
+	inline Size size(){return _size;}
+
+private:
+	Size _size;
+	vector<Rect> _rects;//occupied, inside the frame
+};
+
+#endif
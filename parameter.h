@@ -27,6 +27,7 @@
 #define _PARAMETER_
 
 #define RESULT_OUTPUT_XML_FILE "output.xml"
+#define TRACK_LOG_FILE "tracks.bin"
 
 // multi-object level tracking parameter
 extern int MAX_TRACKER_NUM;
@@ -35,6 +36,7 @@ extern int EXPERT_THRESH;
 extern double BODYSIZE_TO_DETECTION_RATIO;
 extern double TRACKING_TO_BODYSIZE_RATIO;
 #define  TRACKING_TO_DETECTION_RATIO BODYSIZE_TO_DETECTION_RATIO*TRACKING_TO_BODYSIZE_RATIO 
+extern int TRACKER_THREAD_NUM;
 
 //single object level parameter
 extern int FRAME_RATE;
@@ -42,5 +44,20 @@ extern double TIME_WINDOW_SIZE;
 
 //hog detection 
 extern double HOG_DETECT_FRAME_RATIO;
+extern int HOG_THREAD_NUM;
+
+//pipelining
+extern int PREFETCH_FRAME_NUM;
+extern int DECODE_THREAD_NUM;
+extern int DETECTION_QUEUE_SIZE;
+
+//output
+extern int HEADLESS;
+extern int RENDER_OUTPUT;
+extern int TRACK_LOG;
+extern int DETECTION_INTERVAL;
+extern int ADAPTIVE_DETECTION_INTERVAL;
+extern int ROI_DETECTION;
+extern int FULL_SWEEP_INTERVAL;
 
 #endif
\ No newline at end of file
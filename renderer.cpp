@@ -0,0 +1,154 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include "renderer.h"
+
+Renderer::Renderer(bool async, bool write_video)
+	:_async(async),
+	_write_video(write_video),
+	_queue(RENDER_QUEUE_SIZE)
+{
+	if (_write_video)
+		_writer.open("output.avi", CV_FOURCC('X','V','I','D'), 9, Size(1280,720), true);
+	if (_async)
+		_worker=std::thread(&Renderer::work,this);
+}
+Renderer::~Renderer()
+{
+	if (_async)
+	{
+		_queue.close();//the queued frames are still written
+		_worker.join();
+	}
+}
+Mat Renderer::render(const FrameSnapshot& snapshot)
+{
+	if (_async)
+	{
+		// the input frame is reused once tracking moves on
+		FrameSnapshot s=snapshot;
+		s.frame=snapshot.frame.clone();
+		_queue.push(s);
+		return Mat();
+	}
+	return draw(snapshot);
+}
+void Renderer::work()
+{
+	FrameSnapshot s;
+	while (_queue.pop(s))
+		draw(s);
+}
+Mat Renderer::draw(const FrameSnapshot& s)
+{
+	Mat frame=s.frame;
+	std::vector<int> quality;
+	quality.push_back(CV_IMWRITE_JPEG_QUALITY);
+	quality.push_back(93);
+
+	// draw detections
+	for (size_t it=0;it<s.detections.size();it++)
+	{
+		if (s.good_detection[it])
+			rectangle(frame,s.detections[it],Scalar(0,255,127),2);
+		else
+			rectangle(frame,s.detections[it],Scalar(0,255,127),1);
+	}
+
+	for (size_t i=0;i<s.tracks.size();i++)
+	{
+		const TrackSnapshot& t=s.tracks[i];
+		rectangle(frame,scaleWin(t.win,1/TRACKING_TO_BODYSIZE_RATIO),cv::Scalar(255, 0, 0),t.is_novice ? 1:2);
+
+		if (t.crossed)
+		{
+			Point centroid(t.win.x + 3, t.win.y + 3);
+			Mat tmp = frame.clone();
+
+			// Only show circle when it hits the line
+			cv::circle(tmp, centroid, 5, cv::Scalar(255, 255, 255), 5);
+
+			std::string countABstr = "Cross A -> B: " + std::to_string(t.counts[0]);
+			std::string countBAstr = "Cross B -> A: " + std::to_string(t.counts[1]);
+			std::string countCDstr = "Cross C -> D: " + std::to_string(t.counts[2]);
+			std::string countDCstr = "Cross D -> C: " + std::to_string(t.counts[3]);
+			int countTotal = t.counts[0] + t.counts[1] + t.counts[2] + t.counts[3];
+			std::string total = "Total: " + std::to_string(countTotal);
+			cv::putText(tmp, countABstr, cv::Point(5, 75), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
+			cv::putText(tmp, countBAstr, cv::Point(5, 100), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
+			cv::putText(tmp, countCDstr, cv::Point(5, 125), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
+			cv::putText(tmp, countDCstr, cv::Point(5, 150), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
+			cv::putText(tmp, total, cv::Point(5, 175), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
+			bool bSuccess = cv::imwrite(t.crossing_file, tmp, quality);
+			if (!bSuccess){
+				std::cout << "Error: Failed to save the image" << std::endl;
+			}
+		}
+
+		Point tx(t.win.x + 10, t.win.y - 10);
+		char buff[10];
+		sprintf(buff, "%d", t.id);
+		string str = buff;
+		putText(frame, str, tx, FONT_HERSHEY_COMPLEX_SMALL, 1, cv::Scalar(255, 0, 0), 2);
+	}
+
+	// screen shot
+	if (s.screenshot)
+	{
+		char buff[20];
+		sprintf(buff,"%d.jpg",s.frame_n);
+		string filename=buff;
+		imwrite(filename,frame);
+	}
+
+	const char* names[4]={"A","B","C","D"};
+	for (int i=0;i<4;i++)
+	{
+		cv::putText(frame, names[i], cv::Point(s.lines[i][1].x + 3, s.lines[i][1].y + 25), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 2);
+	}
+	for (int i=0;i<4;i++)
+	{
+		line(frame, s.lines[i][0], s.lines[i][1], Scalar(0, 0, 255), 2, 8);
+	}
+
+	std::string countABstr = "Cross A -> B: " + std::to_string(s.counts[0]);
+	std::string countBAstr = "Cross B -> A: " + std::to_string(s.counts[1]);
+	std::string countCDstr = "Cross C -> D: " + std::to_string(s.counts[2]);
+	std::string countDCstr = "Cross D -> C: " + std::to_string(s.counts[3]);
+	int countTotal = s.counts[0] + s.counts[1] + s.counts[2] + s.counts[3];
+	std::string total = "Total: " + std::to_string(countTotal);
+	cv::putText(frame, countABstr, cv::Point(5, 75), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
+	cv::putText(frame, countBAstr, cv::Point(5, 100), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
+	cv::putText(frame, countCDstr, cv::Point(5, 125), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
+	cv::putText(frame, countDCstr, cv::Point(5, 150), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
+	cv::putText(frame, total, cv::Point(5, 175), cv::FONT_HERSHEY_DUPLEX, 1, cv::Scalar(0, 0, 255), 2);
+
+	if (frame.cols > 1920 || frame.rows > 1080) {
+		cv::pyrDown(frame, frame, cv::Size(frame.cols / 2, frame.rows / 2));
+	}
+	if (_write_video)
+		_writer.write(frame);
+	return frame;
+}
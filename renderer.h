@@ -0,0 +1,96 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <thread>
+
+#include "opencv2/opencv.hpp"
+
+#include "parameter.h"
+#include "util.h"
+#include "threadUtil.h"
+
+using namespace cv;
+using namespace std;
+
+#define RENDER_QUEUE_SIZE 16 // frames the async renderer may lag behind before tracking waits
+
+// a tracker as drawn on one frame
+typedef struct TrackSnapshot
+{
+	Rect win;//tracking window
+	int id;
+	bool is_novice;
+	// crossing of a counting line on this frame, saved as a picture
+	bool crossed;
+	int counts[4];//AB, BA, CD, DC after the crossing
+	string crossing_file;
+	TrackSnapshot(Rect w,int i,bool novice):win(w),id(i),is_novice(novice),crossed(false){}
+}TrackSnapshot;
+
+// everything needed to annotate a frame, filled by the tracker manager
+typedef struct FrameSnapshot
+{
+	Mat frame;//the input frame, drawn on by a synchronous renderer
+	int frame_n;
+	vector<Rect> detections;
+	vector<bool> good_detection;
+	vector<TrackSnapshot> tracks;//in drawing order
+	Point lines[4][2];//counting lines A, B, C, D
+	int counts[4];//AB, BA, CD, DC
+	bool screenshot;//save the frame as "<frame_n>.jpg"
+	FrameSnapshot():frame_n(0),screenshot(false){}
+}FrameSnapshot;
+
+/*
+Renderer:
+Draws the detections, tracks, counting lines and counters of a frame snapshot,
+saves the crossing pictures and writes the annotated frames to "output.avi".
+A synchronous renderer does this in render(), on the snapshot's frame, and
+returns the annotated frame for display; an asynchronous one queues the
+snapshot with a copy of the frame for its own thread and returns at once, so
+drawing and encoding stay off the tracking thread.
+*/
+class Renderer
+{
+public:
+	Renderer(bool async, bool write_video);
+	~Renderer();
+	Mat render(const FrameSnapshot& snapshot);//the annotated frame, empty when async
+
+private:
+	Mat draw(const FrameSnapshot& s);
+	void work();
+
+	bool _async;
+	VideoWriter _writer;
+	bool _write_video;
+	BoundedQueue<FrameSnapshot> _queue;
+	std::thread _worker;
+};
+
+#endif
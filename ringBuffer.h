@@ -0,0 +1,66 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <vector>
+
+using namespace std;
+
+/*
+Ring Buffer:
+The last capacity elements pushed, in a storage allocated once; pushing to a
+full buffer overwrites the oldest element. Element 0 is the oldest one.
+*/
+template<class T> class RingBuffer
+{
+public:
+	RingBuffer(size_t capacity):_items(capacity>0 ? capacity:1),_first(0),_size(0){}
+
+	inline void push_back(const T& item)
+	{
+		if (_size<_items.size())
+			_items[(_first+_size++)%_items.size()]=item;
+		else
+		{
+			_items[_first]=item;
+			_first=(_first+1)%_items.size();
+		}
+	}
+	inline T& operator[](size_t i){return _items[(_first+i)%_items.size()];}
+	inline T& back(){return (*this)[_size-1];}
+	inline size_t size() const {return _size;}
+	inline size_t capacity() const {return _items.size();}
+	inline bool empty() const {return _size==0;}
+	inline void clear(){_first=0;_size=0;}
+
+private:
+	vector<T> _items;
+	size_t _first;//index of the oldest element
+	size_t _size;
+};
+
+#endif
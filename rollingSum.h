@@ -0,0 +1,69 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef ROLLING_SUM_H
+#define ROLLING_SUM_H
+
+#include <vector>
+
+using namespace std;
+
+/*
+Rolling Sum:
+The sum of the last capacity values of a sequence, kept up to date as values
+are pushed or the newest one is changed, in O(1) and with a storage
+allocated once. Before capacity values are pushed, the missing ones count
+as 0; size() is the number of values pushed, up to capacity.
+*/
+template<class T> class RollingSum
+{
+public:
+	RollingSum(size_t capacity):_values(capacity>0 ? capacity:1,T()),_next(0),_size(0),_sum(){}
+
+	inline void push(T v)
+	{
+		_sum+=v-_values[_next];
+		_values[_next]=v;
+		_next=(_next+1)%_values.size();
+		_size=_size<_values.size() ? _size+1 : _size;
+	}
+	inline void setBack(T v)//change the newest value
+	{
+		size_t last=(_next+_values.size()-1)%_values.size();
+		_sum+=v-_values[last];
+		_values[last]=v;
+	}
+	inline T sum() const {return _sum;}
+	inline size_t size() const {return _size;}
+	inline size_t capacity() const {return _values.size();}
+
+private:
+	vector<T> _values;
+	size_t _next;//slot of the next value
+	size_t _size;
+	T _sum;
+};
+
+#endif
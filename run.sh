@@ -1,2 +1,2 @@
-./tracking ../../test.avi 0 1 355
+./tracking ../../test.avi 0 1 ../darknet/det.txt
 
@@ -0,0 +1,107 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include "threadUtil.h"
+
+ThreadPool::ThreadPool(int thread_num)
+	:_body(NULL),
+	_n(0),
+	_next(0),
+	_finished(0),
+	_generation(0),
+	_stop(false)
+{
+	for (int i=1;i<thread_num;i++)
+		_workers.push_back(std::thread(&ThreadPool::work,this));
+}
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop=true;
+	}
+	_job_ready.notify_all();
+	for (size_t i=0;i<_workers.size();i++)
+		_workers[i].join();
+}
+void ThreadPool::parallelFor(int n, const std::function<void(int)>& body)
+{
+	if (_workers.empty() || n<=1)
+	{
+		for (int i=0;i<n;i++)
+			body(i);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_body=&body;
+		_n=n;
+		_next=0;
+		_finished=0;
+		_generation++;
+	}
+	_job_ready.notify_all();
+
+	while (runNext())
+		;
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (_finished<_n)
+		_job_done.wait(lock);
+	_body=NULL;
+}
+bool ThreadPool::runNext()
+{
+	int i;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_body==NULL || _next>=_n)
+			return false;
+		i=_next++;
+	}
+	(*_body)(i);
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (++_finished==_n)
+			_job_done.notify_all();
+	}
+	return true;
+}
+void ThreadPool::work()
+{
+	unsigned seen=0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			while (!_stop && _generation==seen)
+				_job_ready.wait(lock);
+			if (_stop)
+				return;
+			seen=_generation;
+		}
+		while (runNext())
+			;
+	}
+}
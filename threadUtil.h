@@ -0,0 +1,119 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef THREAD_UTIL_H
+#define THREAD_UTIL_H
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+/*
+Bounded Queue:
+A blocking FIFO with a fixed capacity for handing data between pipeline
+stages. push() waits while the queue is full and pop() while it is empty.
+After close(), push() fails at once and pop() fails when the queue runs dry.
+*/
+template<class T> class BoundedQueue
+{
+public:
+	BoundedQueue(size_t capacity):_capacity(capacity>0 ? capacity:1),_closed(false){}
+
+	bool push(const T& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (!_closed && _items.size()>=_capacity)
+			_not_full.wait(lock);
+		if (_closed)
+			return false;
+		_items.push_back(item);
+		_not_empty.notify_one();
+		return true;
+	}
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (!_closed && _items.empty())
+			_not_empty.wait(lock);
+		if (_items.empty())
+			return false;
+		item=_items.front();
+		_items.pop_front();
+		_not_full.notify_one();
+		return true;
+	}
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_closed=true;
+		_not_full.notify_all();
+		_not_empty.notify_all();
+	}
+
+private:
+	std::deque<T> _items;
+	size_t _capacity;
+	bool _closed;
+	std::mutex _mutex;
+	std::condition_variable _not_full;
+	std::condition_variable _not_empty;
+};
+
+/*
+Thread Pool:
+A fixed set of worker threads for data-parallel loops. parallelFor(n,body)
+calls body(0)..body(n-1) on the workers and the calling thread and returns
+when all calls are done; the order of the calls is unspecified. A pool of
+size 1 has no workers and runs the loop on the calling thread. Only one
+thread may call parallelFor at a time.
+*/
+class ThreadPool
+{
+public:
+	ThreadPool(int thread_num);
+	~ThreadPool();
+	void parallelFor(int n, const std::function<void(int)>& body);
+	inline int size(){return (int)_workers.size()+1;}
+
+private:
+	void work();
+	bool runNext();//run one pending iteration, false if there is none
+
+	std::vector<std::thread> _workers;
+	std::mutex _mutex;
+	std::condition_variable _job_ready;
+	std::condition_variable _job_done;
+	const std::function<void(int)>* _body;
+	int _n;
+	int _next;//next iteration to hand out
+	int _finished;
+	unsigned _generation;//incremented for each loop, so workers wake up once per loop
+	bool _stop;
+};
+
+#endif
@@ -0,0 +1,137 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+/*
+USAGE:
+
+	assignBench [max_detection_num] [iterations]
+
+	Times the association of detections with trackers on synthetic crowds of 10, 25, 50, 100, ... up 
+	to max_detection_num (default 200) people: the same detections x (trackers + dummies) matrix as 
+	TrakerManager::doHungarianAlg(), with pairs beyond the association radius forbidden, solved by 
+	Munkres and by LapJV. Both must find assignments of the same total cost.
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "munkres.h"
+#include "lapjv.h"
+
+using namespace std;
+
+#define ASSOCIATION_RADIUS 60
+#define DUMMY_COST 100000
+
+// a crowd in a 1280x720 frame: each detection near the tracker of its person, some people missed
+static Matrix<double> makeCrowd(int n, mt19937& rng)
+{
+	uniform_real_distribution<double> x_dist(0,1280), y_dist(0,720), noise(-15,15);
+	vector<double> tx(n), ty(n);
+	for (int j=0;j<n;j++)
+	{
+		tx[j]=x_dist(rng);
+		ty[j]=y_dist(rng);
+	}
+	Matrix<double> matrix(n,2*n);
+	for (int i=0;i<n;i++)
+	{
+		bool missed= i%10==9;//a new person instead
+		double dx= missed ? x_dist(rng) : tx[i]+noise(rng);
+		double dy= missed ? y_dist(rng) : ty[i]+noise(rng);
+		for (int j=0;j<2*n;j++)
+		{
+			if (j<n)
+			{
+				double d=sqrt((tx[j]-dx)*(tx[j]-dx)+(ty[j]-dy)*(ty[j]-dy));
+				matrix(i,j)= d<ASSOCIATION_RADIUS ? d : ASSIGNMENT_INFINITY;
+			}
+			else
+				matrix(i,j)=DUMMY_COST;
+		}
+	}
+	return matrix;
+}
+
+// total cost of the assignment (the zeros of solved) on cost, -1 if a row is not assigned exactly once
+static double totalCost(Matrix<double>& cost, Matrix<double>& solved)
+{
+	double total=0;
+	for (int i=0;i<cost.rows();i++)
+	{
+		int assigned=0;
+		for (int j=0;j<cost.columns();j++)
+		{
+			if (solved(i,j)==0)
+			{
+				assigned++;
+				total+= cost(i,j)==ASSIGNMENT_INFINITY ? DUMMY_COST*10.0 : cost(i,j);
+			}
+		}
+		if (assigned!=1)
+			return -1;
+	}
+	return total;
+}
+
+int main(int argc,char** argv)
+{
+	int max_n= argc>1 ? atoi(argv[1]) : 200;
+	int iterations= argc>2 ? atoi(argv[2]) : 10;
+
+	mt19937 rng(12345);
+	bool same=true;
+	for (int n=10;n<=max_n;n= n<25 ? 25 : 2*n)
+	{
+		double munkres_ms=0, lapjv_ms=0;
+		for (int it=0;it<iterations;it++)
+		{
+			Matrix<double> cost=makeCrowd(n,rng);
+
+			Matrix<double> m1=cost;
+			chrono::steady_clock::time_point t0=chrono::steady_clock::now();
+			Munkres munkres;
+			munkres.solve(m1);
+			chrono::steady_clock::time_point t1=chrono::steady_clock::now();
+			Matrix<double> m2=cost;
+			LapJV lapjv;
+			lapjv.solve(m2);
+			chrono::steady_clock::time_point t2=chrono::steady_clock::now();
+			munkres_ms+=chrono::duration<double,milli>(t1-t0).count();
+			lapjv_ms+=chrono::duration<double,milli>(t2-t1).count();
+
+			double c1=totalCost(cost,m1);
+			double c2=totalCost(cost,m2);
+			if (c1<0 || c2<0 || fabs(c1-c2)>1e-6*max(1.0,fabs(c1)))
+			{
+				cout<<"different costs for "<<n<<" detections: munkres "<<c1<<", lapjv "<<c2<<endl;
+				same=false;
+			}
+		}
+		cout<<n<<" detections: munkres "<<munkres_ms/iterations<<" ms, lapjv "<<lapjv_ms/iterations<<" ms"<<endl;
+	}
+	return same ? 0 : 1;
+}
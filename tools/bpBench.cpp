@@ -0,0 +1,124 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+/*
+USAGE:
+
+	bpBench [template_num] [iterations]
+
+	Times the confidence map of one tracker with template_num appearance templates (default 20, 
+	the usual MAX_TEMPLATE_SIZE) on a synthetic 1280x720 frame: once template by template, each 
+	map back-projected with calcBackProject(), masked and added to the average as the tracker used 
+	to do, and once with the fused kernel AppTemplate::calcEnsembleBP(). Both maps must be the same 
+	up to the float rounding of the average.
+*/
+
+#include <iostream>
+
+#include "appTemplate.h"
+#include "frameSet.h"
+
+using namespace std;
+
+double TRACKING_TO_BODYSIZE_RATIO=0.5;
+
+// the confidence map of one template as the tracker computed it before the bin planes
+static void referenceBP(FrameSet* frame_set, AppTemplate* tr, Mat& occ_map, Rect ROI, Mat& confidence_map)
+{
+	confidence_map=Mat::zeros(ROI.height,ROI.width,CV_8UC1);
+	Rect frame_win(0,0,frame_set->cols(),frame_set->rows());
+	Rect roi=frame_win & ROI;//the rest of the win will be filled with zero
+
+	Mat roi_set[3];
+	frame_set->getRoi(roi,roi_set);
+	Mat roi_backproj(confidence_map,roi-Point(ROI.x, ROI.y));
+	Mat roi_mask(occ_map,roi);
+	int channels[]={tr->getChannel(0),tr->getChannel(1)};
+	float range0[]={0,channels[0]==3 ? 179.0f : 255.0f};//the hue is in [0,179]
+	float range1[]={0,channels[1]==3 ? 179.0f : 255.0f};
+	const float* ranges[]={range0,range1};
+	calcBackProject(roi_set,3,channels,tr->getHist(),roi_backproj,ranges);
+
+	roi_backproj.setTo(Scalar(0.0),roi_mask);
+	confidence_map.convertTo(confidence_map,CV_32FC1);//[0,255]
+}
+
+int main(int argc,char** argv)
+{
+	int template_num= argc>1 ? atoi(argv[1]) : 20;
+	int iterations= argc>2 ? atoi(argv[2]) : 200;
+
+	// smooth random colors, so the templates pick different channels
+	Mat frame(720,1280,CV_8UC3);
+	randu(frame,Scalar::all(0),Scalar::all(255));
+	GaussianBlur(frame,frame,Size(15,15),5);
+	FrameSet frame_set;
+	frame_set.setFrame(frame);
+
+	Rect frame_win(0,0,frame.cols,frame.rows);
+	Mat occ_map(frame.rows,frame.cols,CV_8UC1,Scalar(0));
+	rectangle(occ_map,Rect(600,300,40,120),Scalar(1),-1);
+
+	// templates of one person, taken at slightly different places
+	vector<AppTemplate*> templates;
+	vector<Point> shifts;
+	for (int i=0;i<template_num;i++)
+	{
+		Rect win(620+(i%5)*2-4,330+(i/5)*2-4,24,60);//tracking window
+		templates.push_back(new AppTemplate(&frame_set,win,i));
+		shifts.push_back(templates.back()->getShiftVector()*(float)win.width);
+	}
+	Rect roi(560,250,120,240);//confidence map window
+
+	// template by template, the reference
+	Mat per_template,map;
+	double t=(double)getTickCount();
+	for (int k=0;k<iterations;k++)
+	{
+		per_template=Mat::zeros(roi.height,roi.width,CV_32FC1);
+		for (int i=0;i<template_num;i++)
+		{
+			referenceBP(&frame_set,templates[i],occ_map,roi+shifts[i],map);
+			per_template+=map;
+		}
+		per_template/=MAX((float)template_num,0.0001);
+	}
+	double t_per_template=((double)getTickCount()-t)/getTickFrequency()*1000/iterations;
+
+	// fused
+	Mat fused;
+	t=(double)getTickCount();
+	for (int k=0;k<iterations;k++)
+		AppTemplate::calcEnsembleBP(&frame_set,occ_map,frame_win,roi,templates.data(),shifts.data(),template_num,fused);
+	double t_fused=((double)getTickCount()-t)/getTickFrequency()*1000/iterations;
+
+	double diff=norm(per_template,fused,NORM_INF);
+	cout<<template_num<<" templates, "<<roi.width<<"x"<<roi.height<<" map"<<endl;
+	cout<<"per template: "<<t_per_template<<" ms"<<endl;
+	cout<<"fused:        "<<t_fused<<" ms"<<endl;
+	cout<<"max difference: "<<diff<<endl;
+
+	for (size_t i=0;i<templates.size();i++)
+		delete templates[i];
+	return diff<1e-3 ? 0 : 1;
+}
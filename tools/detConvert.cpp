@@ -0,0 +1,126 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+/*
+USAGE:
+
+	detConvert <input_detection_file> <output_bin_file>
+
+	<input_detection_file>: a '.xml' detection file (the structure read by XMLBBoxReader) or a
+	text file with one box per line: "<frame> <x1> <y1> <x2> <y2> [confidence]"
+	<output_bin_file>: the binary detection file to write (see binDetection.h), which can be
+	passed to Hierarchy_Ensemble in place of the original file.
+*/
+
+#include <iostream>
+
+#include "binDetection.h"
+#include "dataReader.h"
+#include "detector.h"
+
+using namespace std;
+
+// the configuration used by detector.cpp, which is otherwise read by main.cpp
+double HOG_DETECT_FRAME_RATIO=1.0;
+int HOG_THREAD_NUM=1;
+int DETECTION_INTERVAL=1;
+int ADAPTIVE_DETECTION_INTERVAL=0;
+
+static int convertXML(const char* input, BinDetectionWriter& writer)
+{
+	XMLBBoxReader reader(input);
+	if (!reader.getOpenSuc())
+		return -1;
+	int frame_num=0;
+	vector<Result2D> result;
+	vector<BinDetRecord> records;
+	while (reader.getNextFrameResult(result))
+	{
+		records.clear();
+		for (size_t i=0;i<result.size();i++)
+		{
+			BinDetRecord r;
+			r.x=result[i].xc-0.5f*result[i].w;
+			r.y=result[i].yc-0.5f*result[i].h;
+			r.w=result[i].w;
+			r.h=result[i].h;
+			r.score=(float)result[i].response;
+			r.cls=0;
+			records.push_back(r);
+		}
+		writer.putNextFrameResult(records);
+		frame_num++;
+	}
+	return frame_num;
+}
+
+static int convertTXT(const char* input, BinDetectionWriter& writer)
+{
+	DetectionSource source(input,false);
+	if (!source.getOpenSuc())
+		return -1;
+	int frame_num=0;
+	vector<BinDetRecord> records;
+	while (!source.isExhausted())
+	{
+		source.detect(Mat(),0);
+		vector<Rect> detection=source.getDetection();
+		vector<double> response=source.getResponse();
+		records.clear();
+		for (size_t i=0;i<detection.size();i++)
+		{
+			BinDetRecord r;
+			r.x=(float)detection[i].x;
+			r.y=(float)detection[i].y;
+			r.w=(float)detection[i].width;
+			r.h=(float)detection[i].height;
+			r.score=(float)response[i];
+			r.cls=0;
+			records.push_back(r);
+		}
+		writer.putNextFrameResult(records);
+		frame_num++;
+	}
+	return frame_num;
+}
+
+int main(int argc,char** argv)
+{
+	if (argc!=3)
+	{
+		cout<<"usage: detConvert <input_detection_file> <output_bin_file>"<<endl;
+		return 1;
+	}
+	string input(argv[1]);
+	size_t dot=input.rfind('.');
+	string ext= dot==string::npos ? "" : input.substr(dot);
+
+	BinDetectionWriter writer(argv[2]);
+	if (!writer.getOpenSuc())
+		return 1;
+	int frame_num= ext==".xml" ? convertXML(argv[1],writer) : convertTXT(argv[1],writer);
+	if (frame_num<0)
+		return 1;
+	cout<<"converted "<<frame_num<<" frames into "<<argv[2]<<endl;
+	return 0;
+}
@@ -0,0 +1,73 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#include <cstring>
+#include <iostream>
+
+#include "trackLog.h"
+
+TrackLog::TrackLog(const char* filename)
+	:_file(NULL),
+	open_success(false),
+	_queue(TRACK_LOG_QUEUE_SIZE)
+{
+	_file=fopen(filename,"wb");
+	if (_file==NULL)
+	{
+		cout<<"can't open the track log "<<filename<<endl;
+		return;
+	}
+	TrackLogHeader header;
+	memcpy(header.magic,TRACK_LOG_MAGIC,4);
+	header.version=TRACK_LOG_VERSION;
+	if (fwrite(&header,sizeof(header),1,_file)!=1)
+	{
+		cout<<"fail to write the track log "<<filename<<endl;
+		fclose(_file);
+		_file=NULL;
+		return;
+	}
+	open_success=true;
+	_worker=std::thread(&TrackLog::work,this);
+}
+TrackLog::~TrackLog()
+{
+	if (!open_success)
+		return;
+	_queue.close();//the queued frames are still written
+	_worker.join();
+	fclose(_file);
+}
+void TrackLog::putNextFrameResult(const vector<TrackLogRecord>& records)
+{
+	if (open_success && !records.empty())
+		_queue.push(records);
+}
+void TrackLog::work()
+{
+	vector<TrackLogRecord> records;
+	while (_queue.pop(records))
+		fwrite(&records[0],sizeof(TrackLogRecord),records.size(),_file);
+}
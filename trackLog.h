@@ -0,0 +1,84 @@
+/*************************************************************
+*	Implemetation of the multi-person tracking system described in paper
+*	"Online Multi-person Tracking by Tracker Hierarchy", Jianming Zhang, 
+*	Liliana Lo Presti, Stan Sclaroff, AVSS 2012
+*	http://www.cs.bu.edu/groups/ivc/html/paper_view.php?id=268
+*
+*	Copyright (C) 2012 Jianming Zhang
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*	If you have problems about this software, please contact: jmzhang@bu.edu
+***************************************************************/
+
+
+#ifndef TRACK_LOG_H
+#define TRACK_LOG_H
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "threadUtil.h"
+
+using namespace std;
+
+/*
+Track Log File:
+The full trajectories of all the trackers, which keep only their recent
+results in memory. The layout is
+
+	[TrackLogHeader][TrackLogRecord x record_num]
+
+with the records of a frame together, frames in order; a trajectory is the
+records of one id. TrackLog appends the records of each frame on a
+background thread, so the tracking thread does not wait for the disk.
+*/
+
+#define TRACK_LOG_MAGIC "HETL"
+#define TRACK_LOG_VERSION 1
+#define TRACK_LOG_QUEUE_SIZE 64 // frames the writer may lag behind before tracking waits
+
+typedef struct TrackLogHeader
+{
+	char magic[4];
+	unsigned int version;
+}TrackLogHeader;
+
+typedef struct TrackLogRecord
+{
+	int frame;
+	int id;
+	short x, y, w, h;//tracking window
+	int is_novice;
+}TrackLogRecord;
+
+class TrackLog
+{
+public:
+	TrackLog(const char* filename);
+	~TrackLog();//writes the queued frames and closes the file
+	void putNextFrameResult(const vector<TrackLogRecord>& records);
+	inline bool getOpenSuc(){return open_success;}
+
+private:
+	void work();
+
+	FILE* _file;
+	bool open_success;
+	BoundedQueue<vector<TrackLogRecord> > _queue;
+	std::thread _worker;
+};
+
+#endif
@@ -22,60 +22,51 @@
 *	If you have problems about this software, please contact: jmzhang@bu.edu
 ***************************************************************/
 
+#include <algorithm>
+#include <cstring>
+
 #include "tracker.h"
 
 #define SCALE_UPDATE_RATE 0.4
 #define HIST_MATCH_UPDATE 0.01
 
-list<EnsembleTracker*> EnsembleTracker::_TRASH_LIST;
-void EnsembleTracker::dump()
+// the templates' pool first, it outlives the trackers
+ObjectPool<AppTemplate> EnsembleTracker::_TEMPLATE_POOL;
+ObjectPool<EnsembleTracker> EnsembleTracker::_POOL;
+TrackerHandle EnsembleTracker::create(int id,Size body_size)
 {
-	for (list<EnsembleTracker*>::iterator it=_neighbors.begin();it!=_neighbors.end();it++)
-	{
-		(*it)->refcDec1();
-	}
-	_TRASH_LIST.push_back(this);
-	_is_dumped=true;
+	return _POOL.create(id,body_size)->getHandle();
 }
-void EnsembleTracker::emptyTrash()
+void EnsembleTracker::destroy(TrackerHandle tracker)
 {
-	for (list<EnsembleTracker*>::iterator it=_TRASH_LIST.begin();it!=_TRASH_LIST.end();)
-	{
-		if ((*it)->_refc==0)
-		{
-			delete (*it);
-			_TRASH_LIST.erase(it++);
-			continue;
-		}
-		it++;
-	}
+	// the neighbors' handles of it become stale, no need to tell them
+	_POOL.destroy(tracker.get());
 }
 inline bool compareTemplate(AppTemplate* t1,AppTemplate* t2)
 {
 	return t1->getScore()>t2->getScore() ? true:false;
 }
 EnsembleTracker::EnsembleTracker(int id,Size body_size,double phi1,double phi2,double phi_max)
-	:_refc(0),_is_dumped(false),
-	_phi1_(phi1),
+	:_phi1_(phi1),
 	_phi2_(phi2),
 	_phi_max_(phi_max),
 	_novice_status_count(0),
 	_template_count(0),
+	_result_history(MAX(4*FRAME_RATE,2)),
 	_ID(id),
-	_kf(4,2,0),
 	_is_novice(false),
 	_match_radius(0),
 	hist_match_score(0),
 	_added_new(true),
-	_record_idx(0)
+	_recent_hits(MAX(4*FRAME_RATE,1)),
+	_keyframe_count(1),
+	_track_done(true)
 	//tracking_count(1)
 {
 	_retained_template=0;
 	//initialize kalman filter
-	_kf.transitionMatrix=*(Mat_<float>(4,4)<<1,0,1,0,0,1,0,1,0,0,1,0,0,0,0,1);
-	setIdentity(_kf.measurementMatrix);
 	updateKfCov(body_size.width);
-	setIdentity(_kf.errorCovPost,Scalar::all(3.0*(double)body_size.width*body_size.width));
+	_kf.setErrorCov((float)(3.0*(double)body_size.width*body_size.width));
 
 	//for long-time appearance template: RGB
 	histSize[0]=8;histSize[1]=8;histSize[2]=8;
@@ -88,34 +79,32 @@ EnsembleTracker::EnsembleTracker(int id,Size body_size,double phi1,double phi2,d
 	}
 
 	//for calculating hitting rate in a time window
-	_recentHitRecord=Mat::zeros(2,4*FRAME_RATE,CV_64FC1);
+	_recent_hits.push(0);//the first keyframe
 }
 EnsembleTracker::~EnsembleTracker()
 {
-	list<AppTemplate*>::iterator it;
+	vector<AppTemplate*>::iterator it;
 	for (it=_template_list.begin();it!=_template_list.end();it++)
 	{
-		delete *it;
+		_TEMPLATE_POOL.destroy(*it);
 	}
-	delete _retained_template;
+	_TEMPLATE_POOL.destroy(_retained_template);
 }
 void EnsembleTracker::updateNeighbors(
-	list<EnsembleTracker*> tr_list,
+	NeighborGrid& grid,
 	double dis_thresh_r,
 	double scale_r1, double scale_r2,
 	double hist_thresh)
 {
-	// erase neighbors
-	for (list<EnsembleTracker*>::iterator it=_neighbors.begin();it!=_neighbors.end();)
+	// erase neighbors, keeping the rest in order
+	size_t kept=0;
+	for (size_t k=0;k<_neighbors.size();k++)
 	{
-		// delete dumped neighbors
-		if ((*it)->getIsDumped())
-		{
-			(*it)->refcDec1();
-			_neighbors.erase(it++);
+		EnsembleTracker* neighbor=_neighbors[k].tracker.get();
+		// delete destroyed neighbors
+		if (neighbor==NULL)
 			continue;
-		}
-		Rect r=(*it)->getBodysizeResult();
+		Rect r=neighbor->getNeighborBodysize();
 		Point2f c1(r.x+0.5f*r.width,r.y+0.5f*r.height);
 		Point2f c2(_result_bodysize_temp.x+0.5f*_result_bodysize_temp.width,_result_bodysize_temp.y+0.5f*_result_bodysize_temp.height);
 		double dis=sqrt(pow(c1.x-c2.x,2.0f)+pow(c1.y-c2.y,2.0f));
@@ -124,57 +113,57 @@ void EnsembleTracker::updateNeighbors(
 		if (
 			dis>dis_thresh_r*_match_radius || 
 			scale_ratio>scale_r1 ||scale_ratio<scale_r2 || 
-			(*it)->getIsNovice())
+			neighbor->getIsNovice())
 		{
-			(*it)->refcDec1();
-			_neighbors.erase(it++);
 			continue;
 		}
-		it++;
+		_neighbors[kept++]=_neighbors[k];
 	}
-	// add new neighbors
-	for (list<EnsembleTracker*>::iterator it=tr_list.begin();it!=tr_list.end();it++)
+	_neighbors.erase(_neighbors.begin()+kept,_neighbors.end());
+
+	// add new neighbors among the trackers around, in ID order
+	Point2d center(_result_bodysize_temp.x+0.5*_result_bodysize_temp.width,_result_bodysize_temp.y+0.5*_result_bodysize_temp.height);
+	grid.query(center,dis_thresh_r*_match_radius,_neighbor_candidates);
+	size_t old_num=_neighbors.size();
+	for (vector<EnsembleTracker*>::iterator it=_neighbor_candidates.begin();it!=_neighbor_candidates.end();it++)
 	{
 		if ((*it)->getIsNovice() || (*it)->getID()==_ID)
 		{
 			continue;
 		}
-		bool alreadyFound=false;
-		for (list<EnsembleTracker*>::iterator k=_neighbors.begin();k!=_neighbors.end();k++)
-		{
-			if ((*k)->getID()==(*it)->getID())
-			{
-				alreadyFound=true;
-				continue;
-			}
-		}
-		if (alreadyFound)
+		Neighbor candidate((*it)->getID(),(*it)->getHandle());
+		if (binary_search(_neighbors.begin(),_neighbors.begin()+old_num,candidate,compareID))//already found
 		{
 			continue;
 		}
-		Rect r=(*it)->getBodysizeResult();
-		Point c((int)(r.x+0.5*r.width),(int)(r.y+0.5*r.height));
+		Rect r=(*it)->getNeighborBodysize();
+		Point c=NeighborGrid::getCenter(*it);
 		double dis=sqrt((_result_bodysize_temp.x+0.5*_result_bodysize_temp.width-c.x)*(_result_bodysize_temp.x+0.5*_result_bodysize_temp.width-c.x)+(_result_bodysize_temp.y+0.5*_result_bodysize_temp.height-c.y)*(_result_bodysize_temp.y+0.5*_result_bodysize_temp.height-c.y));
 		double scale_ratio=(double)r.width/(double)_result_bodysize_temp.width;
-		double h_match=compareHisto((*it)->hist);
 		if (
 			dis<dis_thresh_r*_match_radius && 
 			scale_ratio<scale_r1 && scale_ratio>scale_r2 && 
-			h_match>hist_thresh)//histogram distance threshold
+			compareHisto((*it)->hist)>hist_thresh)//histogram distance threshold
 		{
-			(*it)->refcAdd1();// one reference
-			_neighbors.push_back((*it));
+			_neighbors.push_back(candidate);
 		}
 	}	
+	inplace_merge(_neighbors.begin(),_neighbors.begin()+old_num,_neighbors.end(),compareID);
+}
+bool EnsembleTracker::isNeighbor(EnsembleTracker* tracker)
+{
+	// IDs are never reused, so the ID is the tracker
+	Neighbor key(tracker->getID(),TrackerHandle());
+	vector<Neighbor>::iterator it=lower_bound(_neighbors.begin(),_neighbors.end(),key,compareID);
+	return it!=_neighbors.end() && it->id==key.id;
 }
-void EnsembleTracker::addAppTemplate(const Mat* frame_set,Rect iniWin)
+void EnsembleTracker::addAppTemplate(FrameSet* frame_set,Rect iniWin)
 {
 	setAddNew(true);// set the flag
-	_recentHitRecord.at<double>(0,_record_idx)=1;
-	_recentHitRecord.at<double>(1,_record_idx)=1.0;
+	_recent_hits.setBack(1);
 	
 	//generate new appearance template and add to list
-	AppTemplate* tra_template=new AppTemplate(frame_set,iniWin,_template_count);
+	AppTemplate* tra_template=_TEMPLATE_POOL.create(frame_set,iniWin,_template_count);
 	_template_list.push_back(tra_template);
 	
 	//update window size
@@ -190,15 +179,46 @@ void EnsembleTracker::addAppTemplate(const Mat* frame_set,Rect iniWin)
 		_result_temp=iniWin;
 		_result_last_no_sus=iniWin;
 		_result_bodysize_temp=scaleWin(iniWin,1/TRACKING_TO_BODYSIZE_RATIO);
-		_retained_template=new AppTemplate(*tra_template);
+		_retained_template=_TEMPLATE_POOL.create(*tra_template);
 	}
 	_template_count++;
 }
-void EnsembleTracker::calcConfidenceMap(const Mat* frame_set,Mat& occ_map)//**********************
+void EnsembleTracker::getTrackRegions(Rect& read_win, Rect& result_win)
 {
+	// the same windows as calcConfidenceMap(), from the prediction of the kalman filter
+	Point center((int)_kf.statePre[0],(int)_kf.statePre[1]);
+	double w=_window_size.width/TRACKING_TO_BODYSIZE_RATIO;
+	double h=_window_size.height/TRACKING_TO_BODYSIZE_RATIO; 
+	h+=2*w;
+	w+=2*w;
+	Rect roi_win((int)(center.x-0.5*w), (int)(center.y-0.5*h),(int)w,(int)h);
+
+	result_win=roi_win;
+	read_win=roi_win;
+	if (!getIsNovice() || _template_list.size()>0)
+	{
+		for (vector<AppTemplate*>::iterator it=_template_list.begin();it!=_template_list.end();it++)
+		{
+			Point shift_vector=(*it)->getShiftVector()*_window_size.width;
+			read_win|=roi_win+shift_vector;
+		}
+	}
+	else
+	{
+		Point shift_vector=_retained_template->getShiftVector()*_window_size.width;
+		read_win|=roi_win+shift_vector;
+	}
+	// a margin for the rounding of the prediction
+	read_win=Rect(read_win.x-2,read_win.y-2,read_win.width+4,read_win.height+4);
+	result_win=Rect(result_win.x-2,result_win.y-2,result_win.width+4,result_win.height+4);
+}
+void EnsembleTracker::calcConfidenceMap(FrameSet* frame_set,OccupancyMap* occ_map)//**********************
+{
+	_bodysize_before_track=_result_bodysize_temp;
+	_track_done=false;
+
 	// use the kalman filter prediction to locate the roi of confidence map (backprojection map)
-	_kf.predict();
-	Point center((int)_kf.statePre.at<float>(0,0),(int)_kf.statePre.at<float>(1,0));
+	Point center((int)_kf.statePre[0],(int)_kf.statePre[1]);
 	double w=_window_size.width/TRACKING_TO_BODYSIZE_RATIO;
 	double h=_window_size.height/TRACKING_TO_BODYSIZE_RATIO; 
 	h+=2*w;
@@ -206,50 +226,61 @@ void EnsembleTracker::calcConfidenceMap(const Mat* frame_set,Mat& occ_map)//****
 
 	Rect roi_win((int)(center.x-0.5*w), (int)(center.y-0.5*h),(int)w,(int)h);
 	_cm_win=roi_win;
-	_confidence_map=Mat::zeros((int)h,(int)w,CV_32FC1);
 
-	//PREVENTING FROM OVERLAPPING WITH FRIEND
-	Mat final_occ_map;
-	occ_map.copyTo(final_occ_map);
-	for (list<EnsembleTracker*>::iterator it=_neighbors.begin();it!=_neighbors.end();it++)
-	{
-		// mask neighbors' area if they are not novices and they have more templates than this one
-		if ((*it)==NULL || (*it)->getIsNovice() || (*it)->getTemplateNum()<(int)_template_list.size())
-			continue;
-		Rect r=scaleWin((*it)->getBodysizeResult(),1.0);
-		ellipse(final_occ_map,Point((int)(r.x+0.5*r.width),(int)(r.y+0.5*r.height)),Size((int)(0.5*r.width),(int)(0.5*r.height)),0,0,360,Scalar(1),-1);
-	}
-	
+	_bp_templates.clear();
+	_bp_shifts.clear();
 	if (!getIsNovice() || _template_list.size()>0)
 	{
-		list<AppTemplate*>::iterator it;
-		float c=0;
+		vector<AppTemplate*>::iterator it;
 		for (it=_template_list.begin();it!=_template_list.end();it++)
 		{
 			AppTemplate* tr=*it;
 			Point shift_vector=tr->getShiftVector()*_window_size.width;//the tracking window
-			tr->calcBP(frame_set,final_occ_map,roi_win+shift_vector);
-			_confidence_map+=tr->getConfidenceMap();//
-			c+=1;//
+			_bp_templates.push_back(tr);
+			_bp_shifts.push_back(shift_vector);
 		} 
-		_confidence_map/=MAX(c,0.0001);
 	}
 	else//when suspension, use the last deleted tracker to draw the confidence map
 	{
 		Point shift_vector=_retained_template->getShiftVector()*_window_size.width;
-		_retained_template->calcBP(frame_set,final_occ_map,roi_win+shift_vector);
-		_confidence_map+=_retained_template->getConfidenceMap();
+		_bp_templates.push_back(_retained_template);
+		_bp_shifts.push_back(shift_vector);
 	}	
+
+	// the occupancy under the templates' windows
+	_occ_win=Rect();
+	for (size_t i=0;i<_bp_shifts.size();i++)
+		_occ_win|=roi_win+_bp_shifts[i];
+	_occ_win&=Rect(0,0,frame_set->cols(),frame_set->rows());
+	occ_map->getMask(_occ_win,_occ_mask);
+
+	//PREVENTING FROM OVERLAPPING WITH FRIEND
+	for (vector<Neighbor>::iterator it=_neighbors.begin();it!=_neighbors.end();it++)
+	{
+		// mask neighbors' area if they are not novices and they have more templates than this one
+		EnsembleTracker* neighbor=it->tracker.get();
+		if (neighbor==NULL || neighbor->getIsNovice() || neighbor->getTemplateNum()<(int)_template_list.size() || _occ_win.area()==0)
+			continue;
+		Rect r=scaleWin(neighbor->getBodysizeResult(),1.0);
+		Point center((int)(r.x+0.5*r.width)-_occ_win.x,(int)(r.y+0.5*r.height)-_occ_win.y);//in the mask
+		ellipse(_occ_mask,center,Size((int)(0.5*r.width),(int)(0.5*r.height)),0,0,360,Scalar(1),-1);
+	}
+
+	// average of the templates' back-projections, in one pass
+	AppTemplate::calcEnsembleBP(frame_set,_occ_mask,_occ_win,roi_win,
+		_bp_templates.data(),_bp_shifts.data(),(int)_bp_templates.size(),_confidence_map);
 }
-void EnsembleTracker::track(const Mat* frame_set,Mat& occ_map)
+void EnsembleTracker::track(FrameSet* frame_set,OccupancyMap* occ_map,bool keyframe)
 {
 	// update covariance of kalman filter
 	updateKfCov(getBodysizeResult().width);
 
-	//for calculation of hitting rate
-	_record_idx=(_record_idx+1)-_recentHitRecord.cols*((_record_idx+1)/_recentHitRecord.cols);
-	_recentHitRecord.at<double>(0,_record_idx)=0.0;
-	_recentHitRecord.at<double>(1,_record_idx)=0.0;
+	//for calculation of hitting rate, only keyframes get a slot
+	if (keyframe)
+	{
+		_recent_hits.push(0);
+		_keyframe_count++;
+	}
 
 	// reset the flag, it will be set as true if a new detection is matched
 	setAddNew(false);
@@ -262,7 +293,7 @@ void EnsembleTracker::track(const Mat* frame_set,Mat& occ_map)
 
 	double alpha;
 	//matching radius updating
-	alpha = MIN(_phi1_*sqrt(_kf.errorCovPre.at<float>(0,0))/(double)_result_bodysize_temp.width+_phi2_,_phi_max_);
+	alpha = MIN(_phi1_*sqrt(_kf.errorCovPre[0])/(double)_result_bodysize_temp.width+_phi2_,_phi_max_);
 	_match_radius=alpha*_result_bodysize_temp.width;
 
 	// center the initial window in the confidence map. NOTE: the confidence map's location is using kalman filter (see calBP)
@@ -280,9 +311,9 @@ void EnsembleTracker::track(const Mat* frame_set,Mat& occ_map)
 	if (getIsNovice())
 	{
 		// copy the errorCovePre  and observation to post without correction
-		_kf.errorCovPre.copyTo(_kf.errorCovPost);
-		_kf.statePost.at<float>(0,0)=(float)(_result_temp.x+0.5*_result_temp.width);
-		_kf.statePost.at<float>(1,0)=(float)(_result_temp.y+0.5*_result_temp.height);
+		memcpy(_kf.errorCovPost,_kf.errorCovPre,sizeof(_kf.errorCovPost));
+		_kf.statePost[0]=(float)(_result_temp.x+0.5*_result_temp.width);
+		_kf.statePost[1]=(float)(_result_temp.y+0.5*_result_temp.height);
 	}
 	else
 	{		
@@ -292,7 +323,7 @@ void EnsembleTracker::track(const Mat* frame_set,Mat& occ_map)
 		correct_kf(_kf,_result_temp);
 	}	
 }
-void EnsembleTracker::calcScore()
+void EnsembleTracker::calcScore(FrameSet* frame_set)
 {
 	Rect roi_result=_result_temp-Point(_cm_win.x,_cm_win.y);
 	Rect roi_bodysize=scaleWin(roi_result,1/TRACKING_TO_BODYSIZE_RATIO);
@@ -300,44 +331,47 @@ void EnsembleTracker::calcScore()
 	if (getIsNovice())
 		return;
 
-	list<AppTemplate*>::iterator it;
+	vector<AppTemplate*>::iterator it;
 	for (it=_template_list.begin();it!=_template_list.end();it++)
 	{
 		if (!getIsNovice())
 		{
-			(*it)->calcScore(roi_result,roi_bodysize);
+			// the template's own map, on the same window and occupancy as the confidence map
+			Point shift_vector=(*it)->getShiftVector()*_window_size.width;
+			(*it)->calcBP(frame_set,_occ_mask,_occ_win,_cm_win+shift_vector,_score_map);
+			(*it)->calcScore(_score_map,_score_sum,_score_sqsum,roi_result,roi_bodysize);
 		}		
 	}
-	_template_list.sort(compareTemplate);//high to low
+	stable_sort(_template_list.begin(),_template_list.end(),compareTemplate);//high to low
 }
 void EnsembleTracker::deletePoorTemplate(double threshold)
 {
 	if (getIsNovice())
 		return;
 	
-	list<AppTemplate*>::iterator it;
-	for (it=_template_list.begin();it!=_template_list.end();)
+	size_t n=_template_list.size();
+	size_t kept=0;
+	for (size_t k=0;k<n;k++)
 	{
-		AppTemplate* tr=*it;
+		AppTemplate* tr=_template_list[k];
 		if (tr->getScore()<=threshold)
 		{
-			if (_template_list.size()==1)
+			if (kept+(n-k)==1)//the only one left
 			{
-				delete _retained_template;
+				_TEMPLATE_POOL.destroy(_retained_template);
 				_retained_template =tr;
-				_template_list.erase(it++);
 				continue;
 			}
-			delete tr;
-			_template_list.erase(it++);
+			_TEMPLATE_POOL.destroy(tr);
+			continue;
 		}
-		else
-			it++;
+		_template_list[kept++]=tr;
 	}
+	_template_list.erase(_template_list.begin()+kept,_template_list.end());
 }
 void EnsembleTracker::deletePoorestTemplate()
 {
-	delete _template_list.back();
+	_TEMPLATE_POOL.destroy(_template_list.back());
 	_template_list.pop_back();
 }
 void EnsembleTracker::demote()
@@ -352,8 +386,8 @@ void EnsembleTracker::promote()
 
 	// reset the kalman filter's post state
 	Rect win=getResult();
-	_kf.statePost.at<float>(0,0)=(float)(win.x+0.5*win.width);
-	_kf.statePost.at<float>(1,0)=(float)(win.y+0.5*win.height);
+	_kf.statePost[0]=(float)(win.x+0.5*win.width);
+	_kf.statePost[1]=(float)(win.y+0.5*win.height);
 
 }
 void EnsembleTracker::updateMatchHist(Mat& frame)
@@ -401,13 +435,13 @@ void EnsembleTracker::registerTrackResult()
 		}
 		else
 		{
-			//Point center((int)_kf.statePost.at<float>(0,0),(int)_kf.statePost.at<float>(1,0));
+			//Point center((int)_kf.statePost[0],(int)_kf.statePost[1]);
 			//_filter_result_history.push_back(Rect((int)(center.x-0.5*_result_temp.width),(int)(center.y-0.5*_result_temp.height),_result_temp.width,_result_temp.height));
 		}									
 	}
 	else //when _is_novice, it only depend on motion model
 	{
-		//Point center((int)_kf.statePost.at<float>(0,0),(int)_kf.statePost.at<float>(1,0));
+		//Point center((int)_kf.statePost[0],(int)_kf.statePost[1]);
 		//Rect lastWin=_filter_result_history.back();
 		//Rect win=Rect((int)(center.x-0.5*_result_temp.width),(int)(center.y-0.5*_result_temp.height),_result_temp.width,_result_temp.height);
 		//_filter_result_history.push_back(win);
@@ -26,17 +26,44 @@
 #ifndef TRACKER_H
 #define TRACKER_H
 
-#include <list>
+#include <vector>
 
 #include "opencv2/opencv.hpp"
 
 #include "appTemplate.h"
+#include "kalmanFilter.h"
+#include "neighborGrid.h"
+#include "objectPool.h"
+#include "ringBuffer.h"
+#include "rollingSum.h"
+#include "occupancyMap.h"
 #include "parameter.h"
 #include "util.h"
 
 using namespace cv;
 using namespace std;
 
+class EnsembleTracker;
+
+/*
+Tracker Handle:
+Refers to a tracker in the pool of trackers (see EnsembleTracker::create()).
+It does not keep the tracker alive: once the tracker is destroyed, get() and
+-> give NULL.
+*/
+class TrackerHandle
+{
+public:
+	TrackerHandle(){}
+	explicit TrackerHandle(PoolHandle h):_h(h){}
+	inline EnsembleTracker* get() const;
+	inline EnsembleTracker* operator->() const {return get();}
+	inline bool operator==(const TrackerHandle& t) const {return _h==t._h;}
+	inline bool operator!=(const TrackerHandle& t) const {return _h!=t._h;}
+
+private:
+	PoolHandle _h;
+};
 
 class EnsembleTracker
 {
@@ -45,31 +72,29 @@ public:
 	EnsembleTracker(int id,Size body_size,double phi1=0.5,double phi2=1.5,double phi_max=4.0);		
 	~EnsembleTracker();	
 
-	//reference counting
-	inline void refcAdd1(){	++_refc;	}
-	inline void refcDec1(){--_refc;_refc=MAX(0,_refc);}
-	inline size_t getRefc(){return _refc;}
-
-	// memory management
-	inline bool getIsDumped(){return _is_dumped;}
-	void dump();
-	static void emptyTrash();
+	// memory management: trackers and their templates are allocated from pools
+	static TrackerHandle create(int id,Size body_size);
+	static void destroy(TrackerHandle tracker);
+	inline TrackerHandle getHandle(){return TrackerHandle(_POOL.getHandle(this));}
 
 	// major functions
 	void updateNeighbors(
-		list<EnsembleTracker*> tr_list,
+		NeighborGrid& grid,//the trackers of the list
 		double dis_thresh_r=2.5, // ratio of distance thresh to '_match_radius'
 		double scale_r1=1.2, double scale_r2=0.8,
 		double hist_thresh=0.5);
-	void addAppTemplate(const Mat* frame_set,Rect iniWin);
-	void track(const Mat* frame_set,Mat& occ_map);
-	void calcConfidenceMap(const Mat* frame_set, Mat& occ_map);//using kalman filter to decide the window
-	void calcScore();//calculate each template's score
+	void addAppTemplate(FrameSet* frame_set,Rect iniWin);
+	void track(FrameSet* frame_set,OccupancyMap* occ_map,bool keyframe=true);//keyframe: detections are associated on this frame
+	void calcConfidenceMap(FrameSet* frame_set, OccupancyMap* occ_map);//using the kalman filter's prediction of this frame to decide the window
+	void calcScore(FrameSet* frame_set);//calculate each template's score
+	// after the prediction, before calcConfidenceMap(): the region of the occupancy map it will read and the window track() will put the result in
+	void getTrackRegions(Rect& read_win, Rect& result_win);
 	void deletePoorTemplate(double threshold);
 	void deletePoorestTemplate();		
 	void demote();
 	void promote();
 	void registerTrackResult();//record result window and the filtered one
+	inline ConstVelocityKalman& getKalmanFilter(){return _kf;}//predicted for all the trackers at once at the start of a frame (see TrakerManager::doWork)
 
 	//for auxiliary stable appearance
 	void updateMatchHist(Mat& frame);
@@ -77,18 +102,18 @@ public:
 	
 	inline double getVel()//get velocity
 	{
-		return (abs(_kf.statePost.at<float>(2,0))+abs(_kf.statePost.at<float>(3,0)))*FRAME_RATE;
+		return (abs(_kf.statePost[2])+abs(_kf.statePost[3]))*FRAME_RATE;
 	}
 	inline void setAddNew(bool b){_added_new=b;}
 	inline bool getAddNew(){return _added_new;}
 	inline double getHitFreq()
 	{
-		Scalar s=sum(_recentHitRecord.row(0));
-		return s[0]/MIN((double)_recentHitRecord.cols,_result_history.size());		
+		// hits per keyframe, frames without detection are not counted as misses
+		return _recent_hits.sum()/MIN((double)_recent_hits.capacity(),_keyframe_count);		
 	}
 	inline double getHitMeanScore()
 	{
-		return mean(_recentHitRecord.row(1))[0];
+		return _recent_hits.sum()/(double)_recent_hits.capacity();
 	}
 	
 	//drawing function
@@ -118,7 +143,7 @@ public:
 	inline double getAssRadius(){return _match_radius;}	
 	inline int getTemplateNum(){return _template_list.size();}
 
-	inline vector<Rect>& getResultHistory(){
+	inline RingBuffer<Rect>& getResultHistory(){
 		return _result_history;
 	}
 
@@ -134,6 +159,11 @@ public:
 			);		
 	}
 	inline bool getIsNovice(){return _is_novice;	}
+	bool isNeighbor(EnsembleTracker* tracker);
+	// the body size result as another tracker's updateNeighbors() sees it: the
+	// one before this frame's tracking until finishTrack() is called
+	inline Rect getNeighborBodysize(){return _track_done ? _result_bodysize_temp : _bodysize_before_track;}
+	inline void finishTrack(){_track_done=true;}
 	inline int getSuspensionCount(){return _novice_status_count;}
 	inline double getHistMatchScore(){return hist_match_score;}
 	inline Rect getResult(){return _result_temp;}
@@ -141,19 +171,21 @@ public:
 
 	inline void updateKfCov(double body_width)
 	{
-		Mat m_temp=*(Mat_<float>(4,4)<<0.025,0,0,0,0,0.025,0,0,0,0,0.25,0,0,0,0,0.25);
-		_kf.processNoiseCov=m_temp*((float)body_width/FRAME_RATE)*((float)body_width/FRAME_RATE);
-		setIdentity(_kf.measurementNoiseCov,Scalar::all(1.0*(float)body_width*(float)body_width));
+		float s=(float)body_width/FRAME_RATE;
+		_kf.setNoise(0.025f*s*s,0.25f*s*s,(float)body_width*(float)body_width);
 	}
 
 private:
 	inline void init_kf(Rect win)
 	{
-		_kf.statePost=*(Mat_<float>(4,1)<<win.x+0.5*win.width,win.y+0.5*win.height,0,0);
+		_kf.statePost[0]=(float)(win.x+0.5*win.width);
+		_kf.statePost[1]=(float)(win.y+0.5*win.height);
+		_kf.statePost[2]=0;
+		_kf.statePost[3]=0;
 	}
-	inline void correct_kf(KalmanFilter& kf, Rect win)
+	inline void correct_kf(ConstVelocityKalman& kf, Rect win)
 	{
-		kf.correct(*(Mat_<float>(2,1)<<win.x+0.5*win.width,win.y+0.5*win.height));
+		kf.correct((float)(win.x+0.5*win.width),(float)(win.y+0.5*win.height));
 	}
 	inline double compareHisto(Mat& h)
 	{
@@ -167,9 +199,17 @@ private:
 		TraResult(Rect win,double like){window=win;likelihood=like;}
 	}TraResult;
 
-	size_t _refc;
-	bool _is_dumped;
-	static list<EnsembleTracker*> _TRASH_LIST;
+	typedef struct Neighbor
+	{
+		int id;
+		TrackerHandle tracker;
+		Neighbor(int i,TrackerHandle t):id(i),tracker(t){}
+	}Neighbor;
+	static inline bool compareID(const Neighbor& n1,const Neighbor& n2){return n1.id<n2.id;}
+
+	friend class TrackerHandle;
+	static ObjectPool<AppTemplate> _TEMPLATE_POOL;
+	static ObjectPool<EnsembleTracker> _POOL;
 
 	double _phi1_,_phi2_,_phi_max_;// system parameters
 
@@ -178,12 +218,12 @@ private:
 	int _novice_status_count;//cout the consecutive times being a novice
 	double _match_radius;
 
-	list<AppTemplate*> _template_list;
+	vector<AppTemplate*> _template_list;
 	AppTemplate* _retained_template;//The last template when all others are eliminated
 	int _template_count;//for its member
-	vector<Rect> _result_history;
+	RingBuffer<Rect> _result_history;//the recent results, see TrackLog for whole trajectories
 	vector<Rect> _filter_result_history;
-	KalmanFilter _kf;
+	ConstVelocityKalman _kf;
 	
 	int histSize[3];
 	float _hRang[3][2];
@@ -195,15 +235,29 @@ private:
 	Size2f _window_size;//
 	Mat _confidence_map;
 	Rect _cm_win;//roi for computing confidence map
+	Mat _occ_mask;//occupancy under the templates' windows, with the neighbors masked
+	Rect _occ_win;//the frame area of _occ_mask
+	vector<AppTemplate*> _bp_templates;//templates and shifts of the confidence map
+	vector<Point> _bp_shifts;
+	Mat _score_map;//one template's confidence map for its score
+	Mat _score_sum;//integrals of _score_map
+	Mat _score_sqsum;
 	Rect _result_temp;//to store the meanshift result
 	Rect _result_last_no_sus;// to store the last result when not _is_novice
 	Rect _result_bodysize_temp;//GT size reuslt
+	Rect _bodysize_before_track;//_result_bodysize_temp before this frame's tracking
+	bool _track_done;//this frame's tracking is finished, see getNeighborBodysize()
 	
-	list<EnsembleTracker*> _neighbors;
+	vector<Neighbor> _neighbors;//sorted by ID
+	vector<EnsembleTracker*> _neighbor_candidates;//for updateNeighbors()
 	bool _added_new;
-	Mat _recentHitRecord; 
-	int _record_idx;
+	RollingSum<int> _recent_hits;//1 for the keyframes a detection was matched on, the newest is this keyframe
+	int _keyframe_count;//keyframes since the tracker was started
 };
 
+inline EnsembleTracker* TrackerHandle::get() const
+{
+	return EnsembleTracker::_POOL.get(_h);
+}
 
 #endif